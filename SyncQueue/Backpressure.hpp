@@ -0,0 +1,134 @@
+#pragma once
+
+#include "SyncQueueCommon.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// 队列已满时提交者的处理方式
+enum class BackpressurePolicy
+{
+    Block = 0,            // 一直等待空位
+    BlockWithTimeout = 1, // 至多等待超时时间，仍无空位时拒绝
+    Reject = 2,           // 立即拒绝，任务不执行
+    CallerRuns = 3,       // 由提交线程直接执行任务
+    DropOldest = 4        // 丢弃同一队列（通道）中最早的任务，为新任务腾出位置
+};
+
+// 线程池 AddTask 的提交结果
+enum class SubmitStatus
+{
+    Queued = 0,      // 已放入队列（DropOldest 时可能挤掉了一个更早的任务）
+    RanInCaller = 1, // 队列已满，按 CallerRuns 在提交线程上执行完毕
+    Rejected = 2,    // 队列已满，按 Reject 被拒绝，任务未执行
+    TimedOut = 3,    // 等待空位超时，任务未执行
+    Stopped = 4      // 线程池已停止，任务未执行
+};
+
+// 任务是否被接受（已入队或已执行）；未被接受时传入的任务没有被移动，调用者可以自行处理
+inline bool Accepted(SubmitStatus status)
+{
+    return status == SubmitStatus::Queued || status == SubmitStatus::RanInCaller;
+}
+
+// 一个队列的背压配置与计数，可在运行中修改
+// 队列只负责等待、拒绝（返回 QueueStatus::FULL）或丢弃最早的任务，CallerRuns 由线程池在收到 FULL 后执行
+class Backpressure
+{
+private:
+    std::atomic<BackpressurePolicy> m_policy;
+    std::atomic<int64_t> m_timeoutNs;
+    std::atomic<uint64_t> m_rejected{0}; // 被拒绝或等待超时的任务数
+    std::atomic<uint64_t> m_dropped{0};  // DropOldest 丢弃的任务数
+
+public:
+    Backpressure(BackpressurePolicy policy, std::chrono::nanoseconds timeout)
+        : m_policy(policy), m_timeoutNs(timeout.count())
+    {
+    }
+
+    void Set(BackpressurePolicy policy, std::chrono::nanoseconds timeout)
+    {
+        m_timeoutNs.store(timeout.count(), std::memory_order_relaxed);
+        m_policy.store(policy, std::memory_order_relaxed);
+    }
+    BackpressurePolicy Policy() const
+    {
+        return m_policy.load(std::memory_order_relaxed);
+    }
+    // 队列满时是否等待空位
+    bool Waits() const
+    {
+        BackpressurePolicy policy = Policy();
+        return policy == BackpressurePolicy::Block || policy == BackpressurePolicy::BlockWithTimeout;
+    }
+    // 本次等待的截止时间，Block 为 time_point::max()
+    std::chrono::steady_clock::time_point Deadline() const
+    {
+        if (Policy() == BackpressurePolicy::Block) return std::chrono::steady_clock::time_point::max();
+        return std::chrono::steady_clock::now() + std::chrono::nanoseconds(m_timeoutNs.load(std::memory_order_relaxed));
+    }
+
+    // 在条件变量上等待 ready() 成立，到达 deadline 仍不成立时返回 false
+    template<typename Pred>
+    static bool Wait(std::condition_variable& cond, std::unique_lock<std::mutex>& lock,
+                     std::chrono::steady_clock::time_point deadline, Pred ready)
+    {
+        if (deadline == std::chrono::steady_clock::time_point::max())
+        {
+            cond.wait(lock, ready);
+            return true;
+        }
+        return cond.wait_until(lock, deadline, ready);
+    }
+
+    void RecordRejected()
+    {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+    }
+    void RecordDropped(uint64_t count = 1)
+    {
+        m_dropped.fetch_add(count, std::memory_order_relaxed);
+    }
+    uint64_t Rejected() const
+    {
+        return m_rejected.load(std::memory_order_relaxed);
+    }
+    uint64_t Dropped() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+    // 供静止检测把被丢弃的任务计入已结束
+    const std::atomic<uint64_t>& DroppedCounter() const
+    {
+        return m_dropped;
+    }
+
+    // 把队列的入队结果转换为提交结果：FULL 时按 CallerRuns 在当前线程执行任务，否则计为拒绝
+    template<typename Task>
+    SubmitStatus Complete(QueueStatus status, Task& task)
+    {
+        switch (status)
+        {
+        case QueueStatus::OK:
+            return SubmitStatus::Queued;
+        case QueueStatus::STOPPED:
+            return SubmitStatus::Stopped;
+        case QueueStatus::TIMEOUT:
+            RecordRejected();
+            return SubmitStatus::TimedOut;
+        default:
+            break;
+        }
+        if (Policy() == BackpressurePolicy::CallerRuns)
+        {
+            task();
+            return SubmitStatus::RanInCaller;
+        }
+        RecordRejected();
+        return SubmitStatus::Rejected;
+    }
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "SyncQueueCommon.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// 有界 Chase-Lev 工作窃取双端队列
+// 拥有者线程在底部 Push/Pop（无锁，只有最后一个元素时才需要一次 CAS），其他线程在顶部 Steal
+// 槽位内直接存放 T：窃取者先用 CAS 抢到下标再搬出元素，槽位的 occupied 标志保证拥有者
+// 不会在窃取者搬出完成之前复用该槽位，因此 T 不要求可平凡复制
+template<typename T>
+class ChaseLevDeque
+{
+private:
+    struct Slot
+    {
+        std::atomic<bool> occupied{false};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* Ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    alignas(CacheLineSize) std::atomic<int64_t> m_top;    // 窃取端
+    alignas(CacheLineSize) std::atomic<int64_t> m_bottom; // 拥有者端
+    alignas(CacheLineSize) std::unique_ptr<Slot[]> m_slots;
+    int64_t m_capacity;
+    int64_t m_mask;
+
+    static int64_t RoundUpPow2(size_t n)
+    {
+        int64_t cap = 2;
+        while (cap < static_cast<int64_t>(n)) cap <<= 1;
+        return cap;
+    }
+
+    void MoveOut(int64_t index, T& out)
+    {
+        Slot& slot = m_slots[index & m_mask];
+        out = std::move(*slot.Ptr());
+        slot.Ptr()->~T();
+        slot.occupied.store(false, std::memory_order_release);
+    }
+
+public:
+    explicit ChaseLevDeque(size_t capacity)
+        : m_top(0),
+          m_bottom(0),
+          m_capacity(RoundUpPow2(capacity)),
+          m_mask(m_capacity - 1)
+    {
+        m_slots.reset(new Slot[m_capacity]);
+    }
+    ~ChaseLevDeque()
+    {
+        for (int64_t i = 0; i < m_capacity; ++i)
+        {
+            if (m_slots[i].occupied.load(std::memory_order_relaxed))
+            {
+                m_slots[i].Ptr()->~T();
+            }
+        }
+    }
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // 仅拥有者调用，队列满时返回 false
+    template<typename F>
+    bool Push(F&& task)
+    {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        if (b - t >= m_capacity) return false;
+
+        Slot& slot = m_slots[b & m_mask];
+        if (slot.occupied.load(std::memory_order_acquire)) return false; // 窃取者还在搬出旧元素
+
+        ::new (static_cast<void*>(slot.storage)) T(std::forward<F>(task));
+        slot.occupied.store(true, std::memory_order_relaxed);
+        m_bottom.store(b + 1, std::memory_order_release); // 发布新元素给窃取者
+        return true;
+    }
+
+    // 仅拥有者调用，后进先出
+    bool Pop(T& task)
+    {
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        // bottom 的写与 top 的读必须全序，与 Steal 中的 seq_cst 读配对
+        m_bottom.store(b, std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_seq_cst);
+
+        if (t > b)
+        {
+            m_bottom.store(b + 1, std::memory_order_release); // 队列为空
+            return false;
+        }
+        if (t == b)
+        {
+            // 只剩最后一个元素，与窃取者竞争
+            bool won = m_top.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_release);
+            if (!won) return false;
+        }
+        MoveOut(b, task);
+        return true;
+    }
+
+    // 任意线程调用，先进先出；队列为空或竞争失败时返回 false
+    bool Steal(T& task)
+    {
+        int64_t t = m_top.load(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_seq_cst);
+        if (t >= b) return false;
+
+        if (!m_top.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return false;
+        }
+        MoveOut(t, task);
+        return true;
+    }
+
+    // 近似值，仅用于判断是否有任务和统计
+    size_t Size() const
+    {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+    bool Empty() const
+    {
+        return Size() == 0;
+    }
+    size_t Capacity() const
+    {
+        return static_cast<size_t>(m_capacity);
+    }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+// 事件计数器：让无锁队列的消费者在没有任务时睡眠，而生产者在没有等待者时只需一次原子读
+// 用法（等待方）：
+//   auto key = ec.PrepareWait();
+//   if (条件已满足) { ec.CancelWait(); } else { ec.Wait(key, deadline); }
+// 生产方在发布数据后调用 NotifyOne/NotifyN/NotifyAll
+// Linux 下直接在纪元字上使用 futex，唤醒 N 个等待者就是一次 FUTEX_WAKE(N)，不需要互斥锁
+class EventCount
+{
+private:
+    std::atomic<uint32_t> m_epoch;
+    std::atomic<uint32_t> m_waiters;
+#if !defined(__linux__)
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+#endif
+
+#if defined(__linux__)
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+
+    uint32_t* FutexWord()
+    {
+        return reinterpret_cast<uint32_t*>(&m_epoch);
+    }
+    void FutexWait(uint32_t key, const struct timespec* timeout)
+    {
+        syscall(SYS_futex, FutexWord(), FUTEX_WAIT_PRIVATE, key, timeout, nullptr, 0);
+    }
+    void FutexWake(size_t count)
+    {
+        int n = count > static_cast<size_t>(INT_MAX) ? INT_MAX : static_cast<int>(count);
+        syscall(SYS_futex, FutexWord(), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+    }
+#endif
+
+    // 唤醒至多 count 个等待者
+    void Notify(size_t count)
+    {
+        if (count == 0) return;
+        // 与等待方 PrepareWait 中的 seq_cst 操作配对，保证不会丢失唤醒
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) == 0) return;
+#if defined(__linux__)
+        m_epoch.fetch_add(1, std::memory_order_release);
+        FutexWake(count);
+#else
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_epoch.fetch_add(1, std::memory_order_release);
+        }
+        if (count >= m_waiters.load(std::memory_order_relaxed))
+        {
+            m_cond.notify_all();
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) m_cond.notify_one();
+#endif
+    }
+
+public:
+    using Key = uint32_t;
+
+    EventCount() : m_epoch(0), m_waiters(0) {}
+    EventCount(const EventCount&) = delete;
+    EventCount& operator=(const EventCount&) = delete;
+
+    Key PrepareWait()
+    {
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        Key key = m_epoch.load(std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // 之后对等待条件的检查不得提前
+        return key;
+    }
+    void CancelWait()
+    {
+        m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    // 等待直到纪元发生变化
+    void Wait(Key key)
+    {
+#if defined(__linux__)
+        while (m_epoch.load(std::memory_order_acquire) == key)
+        {
+            FutexWait(key, nullptr);
+        }
+#else
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this, key]{ return m_epoch.load(std::memory_order_acquire) != key; });
+        }
+#endif
+        m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    // 等待直到纪元发生变化，超时返回 false；deadline 为 time_point::max() 时不超时
+    template<typename Clock, typename Duration>
+    bool Wait(Key key, const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        if (deadline == std::chrono::time_point<Clock, Duration>::max())
+        {
+            Wait(key);
+            return true;
+        }
+#if defined(__linux__)
+        while (m_epoch.load(std::memory_order_acquire) == key)
+        {
+            auto remaining = deadline - Clock::now();
+            if (remaining <= Duration::zero()) break;
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+            ts.tv_nsec = static_cast<long>(ns % 1000000000);
+            FutexWait(key, &ts);
+        }
+        bool notified = m_epoch.load(std::memory_order_acquire) != key;
+#else
+        bool notified;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            notified = m_cond.wait_until(
+                lock,
+                deadline,
+                [this, key]{ return m_epoch.load(std::memory_order_acquire) != key; });
+        }
+#endif
+        m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+        return notified;
+    }
+
+    void NotifyOne() { Notify(1); }
+    void NotifyN(size_t count) { Notify(count); }
+    void NotifyAll() { Notify(SIZE_MAX); }
+
+    // 当前登记的等待者数量（近似值）
+    uint32_t Waiters() const
+    {
+        return m_waiters.load(std::memory_order_relaxed);
+    }
+};
@@ -1,98 +1,29 @@
 #pragma once
 
-#include <list>
-#include <mutex>
-#include <condition_variable>
-#include <atomic>
+#include "LaneTaskQueue.hpp"
+
+#include <chrono>
 
 const int MaxTaskSize = 200;
+// 固定线程池的任务队列：通道满时默认一直等待，空闲消费者一直停靠到有任务或队列停止
 template<typename T>
-class SyncQueue
-{ 
-private:
-    std::list<T> m_queue;
-    mutable std::mutex m_mutex;
-    std::condition_variable m_notFull;
-    std::condition_variable m_notEmpty;
-    size_t m_maxSize;
-    std::atomic<bool> m_needStop;
-
-    bool IsFull() const
-    {
-        return m_queue.size() >= m_maxSize;
-    }
-    bool IsEmpty() const
-    {
-        return m_queue.empty();
-    }
-
-    template<typename F>
-    void Add(F&& task)
-    {
-        std::unique_lock<std::mutex> locker(m_mutex);
-        m_notFull.wait(locker,[this]{return m_needStop.load() || !IsFull();});
-
-        if(m_needStop.load()) return;
-        m_queue.emplace_back(std::forward<F>(task));
-        m_notEmpty.notify_one();
-    }
-
-    void Take(T& task)
-    {
-        std::unique_lock<std::mutex> locker(m_mutex);
-        m_notEmpty.wait(locker,[this]{return m_needStop.load() || !IsEmpty();});
-
-        if(m_needStop.load()) return;
-        task = std::move(m_queue.front());
-        m_queue.pop_front();
-        m_notFull.notify_one();
-    }
-
+class FixedSyncQueue : public LaneTaskQueue<T>
+{
 public:
-    SyncQueue(size_t maxSize = MaxTaskSize):
-    m_maxSize(maxSize),m_needStop(false){}
-    ~SyncQueue(){}
-
-    void AddTask(T&& task)
-    {
-        Add(std::forward<T>(task));
-    }
-    void AddTask(const T& task)
-    {
-        Add(task);
-    }
-    void TakeTask(T& task)
-    {
-        Take(task);
-    }
-    // 停止队列，可选择丢弃未处理任务
-    void Stop(bool discardPending = false)
-    {
-        bool expected = false;
-        if (!m_needStop.compare_exchange_strong(expected, true)) 
-        { return;} // 已经停止，避免重复停止
-           
-        {
-            std::lock_guard<std::mutex> locker(m_mutex);
-            if (discardPending) m_queue.clear();
-        }
-        m_notFull.notify_all();
-        m_notEmpty.notify_all();
-    }
-
-    bool Empty() const
-    {
-        std::lock_guard<std::mutex> locker(m_mutex);
-        return m_queue.empty();
-    }
-    bool Full() const
-    {
-        std::lock_guard<std::mutex> locker(m_mutex);
-        return m_queue.size() >= m_maxSize;
-    }
-    size_t Size() const
-    {
-        std::lock_guard<std::mutex> locker(m_mutex);
-        return m_queue.size();
-    }
-};
\ No newline at end of file
+    FixedSyncQueue(size_t maxSize = MaxTaskSize, QueueBackend backend = QueueBackend::List)
+    :LaneTaskQueue<T>(maxSize, backend, BackpressurePolicy::Block, std::chrono::seconds(1))
+    {}
+
+    // 消费者 consumer 取出一个任务，consumers 为竞争该队列的消费者数量，用于计算公平份额
+    // 每次从共享通道取一小批放进自己的批次，之后的调用先取批次中剩下的任务；没有任务时先自旋后停靠
+    // 队列停止时返回 false
+    bool TakeTask(T& task, size_t consumer, size_t consumers)
+    {
+        if(this->m_needStop.load()) return false;
+        QueueStatus status = this->m_parker.Park(
+            [this, &task, consumer, consumers]{ return this->TryTakeFor(consumer, task, consumers); },
+            [this]{ return this->HasWork(); },
+            this->m_needStop);
+        return status == QueueStatus::OK;
+    }
+};
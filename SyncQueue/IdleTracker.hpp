@@ -0,0 +1,111 @@
+#pragma once
+
+#include "EventCount.hpp"
+#include "SyncQueueCommon.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 线程池静止检测：记录已接受与已结束（执行完、被丢弃或提交失败撤销）的任务数，
+// 两者相等时没有排队或正在执行的任务。计数按线程分片、只增不减，提交与完成路径上各一次原子加，
+// 只有存在 WaitIdle 等待者时，完成任务的线程才汇总各分片并在静止时唤醒等待者
+//
+// 汇总时先读全部 completed，再读全部 submitted：两者都单调递增，且任务总是先计入 submitted，
+// 因此读到相等时，读完 completed 的那一刻确实没有未完成的任务，分片读取不是同一时刻也不会误判
+class IdleTracker
+{
+private:
+    struct alignas(CacheLineSize) Shard
+    {
+        std::atomic<uint64_t> submitted{0};
+        std::atomic<uint64_t> completed{0};
+    };
+
+    std::unique_ptr<Shard[]> m_shards;
+    size_t m_shardCount;
+    std::atomic<uint32_t> m_waiters{0};
+    std::atomic<bool> m_closed{false}; // 线程池停止后等待者立即返回
+    const std::atomic<uint64_t>* m_discarded = nullptr; // 队列内丢弃的任务数（DropOldest），视为已结束
+    EventCount m_idle;
+
+    Shard& LocalShard()
+    {
+        return m_shards[HomeShard(m_shardCount)];
+    }
+
+public:
+    explicit IdleTracker(size_t shardCount = DefaultShardCount())
+        : m_shards(new Shard[shardCount == 0 ? 1 : shardCount]),
+          m_shardCount(shardCount == 0 ? 1 : shardCount)
+    {}
+    IdleTracker(const IdleTracker&) = delete;
+    IdleTracker& operator=(const IdleTracker&) = delete;
+
+    // 指定队列内被丢弃的任务计数，这些任务不会执行，也要计入已结束；
+    // 丢弃总是发生在另一个任务入队的过程中，那个任务结束时会重新检查，因此这里不需要单独唤醒
+    void SetDiscardCounter(const std::atomic<uint64_t>* discarded)
+    {
+        m_discarded = discarded;
+    }
+
+    // 放入队列之前调用，先于对应的 Completed
+    void Submitted(uint64_t count = 1)
+    {
+        LocalShard().submitted.fetch_add(count, std::memory_order_seq_cst);
+    }
+    // 任务执行完毕，或提交未被接受时撤销之前的 Submitted
+    void Completed(uint64_t count = 1)
+    {
+        LocalShard().completed.fetch_add(count, std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_seq_cst) > 0 && Idle()) m_idle.NotifyAll();
+    }
+
+    bool Idle() const
+    {
+        uint64_t completed = 0;
+        for (size_t i = 0; i < m_shardCount; ++i)
+        {
+            completed += m_shards[i].completed.load(std::memory_order_seq_cst);
+        }
+        if (m_discarded) completed += m_discarded->load(std::memory_order_seq_cst);
+        uint64_t submitted = 0;
+        for (size_t i = 0; i < m_shardCount; ++i)
+        {
+            submitted += m_shards[i].submitted.load(std::memory_order_seq_cst);
+        }
+        return submitted == completed;
+    }
+
+    // 已停止时不再等待
+    void Close()
+    {
+        m_closed.store(true, std::memory_order_seq_cst);
+        m_idle.NotifyAll();
+    }
+
+    // 等待静止或停止，超时返回 false；deadline 为 time_point::max() 时不超时
+    bool WaitIdle(std::chrono::steady_clock::time_point deadline)
+    {
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        bool idle = true;
+        while (!m_closed.load(std::memory_order_seq_cst) && !Idle())
+        {
+            auto key = m_idle.PrepareWait();
+            if (m_closed.load(std::memory_order_seq_cst) || Idle())
+            {
+                m_idle.CancelWait();
+                break;
+            }
+            if (!m_idle.Wait(key, deadline))
+            {
+                idle = m_closed.load(std::memory_order_seq_cst) || Idle();
+                break;
+            }
+        }
+        m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+        return idle;
+    }
+};
@@ -0,0 +1,536 @@
+#pragma once
+
+#include "Backpressure.hpp"
+#include "EventCount.hpp"
+#include "MpmcRingBuffer.hpp"
+#include "Parker.hpp"
+#include "PriorityLanes.hpp"
+#include "ShardedLanes.hpp"
+#include "SyncQueueCommon.hpp"
+#include "WorkerCounters.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// FixedSyncQueue 与 CacheSyncQueue 共用的有界多通道任务队列：存储后端（List / RingBuffer / Sharded）、
+// 优先级通道与背压策略都在这里实现，派生类只提供取任务时的阻塞方式
+// 任务按优先级分入若干条通道，每条通道有独立的容量上限与满队列等待，
+// 消费者总是先取优先级最高的非空通道（可选老化避免低优先级饿死）
+// 每个消费者一次从共享通道取出一小批任务放在自己的批次里逐个执行，摊薄共享通道的同步开销；
+// 批次中尚未开始的任务仍然可以被其他消费者取走
+template<typename T>
+class LaneTaskQueue
+{
+private:
+    QueueBackend m_backend;
+
+    // List 后端：所有通道共用一把锁
+    std::list<T> m_queues[PriorityLaneCount];
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notFull[PriorityLaneCount];
+    std::atomic<size_t> m_listSize; // 所有通道任务总数的无锁镜像，供停靠线程廉价地检查是否有任务
+
+    // RingBuffer 后端：每条通道一个无锁环形队列，队列满时生产者通过 EventCount 睡眠
+    std::unique_ptr<MpmcRingBuffer<T>> m_rings[PriorityLaneCount];
+    EventCount m_ringNotFull[PriorityLaneCount];
+
+    // Sharded 后端：每个分片一把锁，见 ShardedLanes.hpp
+    std::unique_ptr<ShardedLanes<T>> m_shards;
+
+    LaneScheduler m_lanes;
+    std::atomic<size_t> m_highWatermark; // 单条通道长度的历史最大值
+
+    size_t m_maxSize; // 每条通道的容量
+    Backpressure m_backpressure; // 通道满时的处理方式
+
+    // 消费者的本地批次。执行中的任务可能等待同一批中靠后的任务，
+    // 这些任务若只有所属消费者能取就会死锁，因此空闲的消费者与帮忙执行任务的线程可以从这里取走任务
+    struct alignas(CacheLineSize) ConsumerBatch
+    {
+        std::mutex mutex;
+        T tasks[MaxTakeBatch];
+        size_t head = 0;
+        std::atomic<size_t> size{0}; // 尚未开始的任务数，供其他消费者无锁检查
+        size_t batchSize = 1;        // 自适应批大小，只由所属消费者读写
+    };
+    std::unique_ptr<ConsumerBatch[]> m_batches;
+    size_t m_batchCount = 0;
+
+    bool UseRing() const
+    {
+        return m_backend == QueueBackend::RingBuffer;
+    }
+    bool UseShards() const
+    {
+        return m_backend == QueueBackend::Sharded;
+    }
+    bool IsFull(size_t lane) const
+    {
+        return m_queues[lane].size() >= m_maxSize;
+    }
+    size_t RingSize() const
+    {
+        size_t size = 0;
+        for (const auto& ring : m_rings) size += ring->Size();
+        return size;
+    }
+    // 持有 m_mutex 时调用，发布新的任务总数
+    void PublishListSize(size_t lane, size_t size)
+    {
+        m_listSize.store(size, std::memory_order_release);
+        UpdateHighWatermark(m_highWatermark, m_queues[lane].size());
+    }
+
+    // 通道满时按背压策略等待、丢弃最早的任务或返回 FULL；被丢弃的任务在释放锁之后才析构，
+    // 它的析构可能触发 future 的后续任务，不能在持有队列锁时运行；applyBackpressure 为 false 时满了直接返回 FULL
+    template<typename F>
+    QueueStatus Add(F&& task, size_t lane, bool applyBackpressure = true)
+    {
+        T dropped;
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+            if(!m_needStop.load() && IsFull(lane))
+            {
+                if(!applyBackpressure) return QueueStatus::FULL;
+                if(m_backpressure.Policy() == BackpressurePolicy::DropOldest)
+                {
+                    dropped = std::move(m_queues[lane].front());
+                    m_queues[lane].pop_front();
+                    m_listSize.store(m_listSize.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+                    m_backpressure.RecordDropped();
+                }
+                else if(!m_backpressure.Waits())
+                {
+                    return QueueStatus::FULL;
+                }
+                else if(!Backpressure::Wait(m_notFull[lane], locker, m_backpressure.Deadline(),
+                                            [this, lane]{return m_needStop.load() || !IsFull(lane);}))
+                {
+                    return QueueStatus::TIMEOUT;
+                }
+            }
+
+            if(m_needStop.load()) return QueueStatus::STOPPED;
+            m_queues[lane].emplace_back(std::forward<F>(task));
+            PublishListSize(lane, m_listSize.load(std::memory_order_relaxed) + 1);
+        }
+        m_parker.NotifyWork();
+        return QueueStatus::OK;
+    }
+
+    // 一次加锁放入一批任务，只唤醒与新任务数量相当的消费者
+    // 通道满时按背压策略等待或丢弃最早的任务；Reject / CallerRuns 时停在第一个放不下的任务
+    template<typename It>
+    size_t AddRange(It first, It last, size_t lane)
+    {
+        size_t added = 0;
+        std::vector<T> dropped;
+        std::unique_lock<std::mutex> locker(m_mutex);
+        auto deadline = m_backpressure.Deadline();
+        while(first != last)
+        {
+            if(!m_needStop.load() && IsFull(lane))
+            {
+                if(m_backpressure.Policy() == BackpressurePolicy::DropOldest)
+                {
+                    dropped.emplace_back(std::move(m_queues[lane].front()));
+                    m_queues[lane].pop_front();
+                    m_listSize.store(m_listSize.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+                    m_backpressure.RecordDropped();
+                }
+                else if(!m_backpressure.Waits()
+                        || !Backpressure::Wait(m_notFull[lane], locker, deadline,
+                                               [this, lane]{return m_needStop.load() || !IsFull(lane);}))
+                {
+                    break;
+                }
+            }
+            if(m_needStop.load()) break;
+
+            size_t batch = 0;
+            for(; first != last && !IsFull(lane); ++first, ++batch)
+            {
+                m_queues[lane].emplace_back(*first);
+            }
+            PublishListSize(lane, m_listSize.load(std::memory_order_relaxed) + batch);
+            added += batch;
+
+            locker.unlock();
+            m_parker.NotifyWork(batch);
+            locker.lock();
+        }
+        locker.unlock();
+        return added;
+    }
+
+    // 环形队列没有锁，DropOldest 从队头弹出一个任务后重试，腾出的位置可能被其他生产者抢走
+    template<typename F>
+    QueueStatus RingAdd(F&& task, size_t lane, bool applyBackpressure = true)
+    {
+        MpmcRingBuffer<T>& ring = *m_rings[lane];
+        auto deadline = std::chrono::steady_clock::time_point::min();
+        while(true)
+        {
+            if(m_needStop.load()) return QueueStatus::STOPPED;
+            if(ring.TryPush(std::forward<F>(task)))
+            {
+                UpdateHighWatermark(m_highWatermark, ring.Size());
+                m_parker.NotifyWork();
+                return QueueStatus::OK;
+            }
+            if(!applyBackpressure) return QueueStatus::FULL;
+            BackpressurePolicy policy = m_backpressure.Policy();
+            if(policy == BackpressurePolicy::DropOldest)
+            {
+                T dropped;
+                if(ring.TryPop(dropped)) m_backpressure.RecordDropped();
+                continue;
+            }
+            if(!m_backpressure.Waits()) return QueueStatus::FULL;
+            if(deadline == std::chrono::steady_clock::time_point::min()) deadline = m_backpressure.Deadline();
+
+            auto key = m_ringNotFull[lane].PrepareWait();
+            if(m_needStop.load() || !ring.Full())
+            {
+                m_ringNotFull[lane].CancelWait();
+                continue;
+            }
+            if(!m_ringNotFull[lane].Wait(key, deadline)) return QueueStatus::TIMEOUT;
+        }
+    }
+
+    template<typename It>
+    size_t RingAddRange(It first, It last, size_t lane)
+    {
+        MpmcRingBuffer<T>& ring = *m_rings[lane];
+        auto deadline = m_backpressure.Deadline();
+        size_t added = 0;
+        while(first != last && !m_needStop.load())
+        {
+            size_t batch = 0;
+            for(; first != last && ring.TryPush(*first); ++first, ++batch) {}
+            added += batch;
+            UpdateHighWatermark(m_highWatermark, ring.Size());
+            m_parker.NotifyWork(batch);
+            if(first == last) break;
+
+            BackpressurePolicy policy = m_backpressure.Policy();
+            if(policy == BackpressurePolicy::DropOldest)
+            {
+                T dropped;
+                if(ring.TryPop(dropped)) m_backpressure.RecordDropped();
+                continue;
+            }
+            if(!m_backpressure.Waits()) break;
+
+            auto key = m_ringNotFull[lane].PrepareWait();
+            if(m_needStop.load() || !ring.Full())
+            {
+                m_ringNotFull[lane].CancelWait();
+                continue;
+            }
+            if(!m_ringNotFull[lane].Wait(key, deadline)) break;
+        }
+        return added;
+    }
+
+    size_t RingTakeLane(size_t lane, T* out, size_t maxCount, size_t consumers)
+    {
+        MpmcRingBuffer<T>& ring = *m_rings[lane];
+        size_t limit = FairTakeCount(ring.Size(), maxCount, consumers);
+        size_t count = 0;
+        while(count < limit && ring.TryPop(out[count])) ++count;
+        m_ringNotFull[lane].NotifyN(count);
+        return count;
+    }
+
+    bool PopBatch(ConsumerBatch& batch, T& task)
+    {
+        if(batch.size.load(std::memory_order_acquire) == 0) return false;
+        std::lock_guard<std::mutex> locker(batch.mutex);
+        size_t size = batch.size.load(std::memory_order_relaxed);
+        if(size == 0) return false;
+        task = std::move(batch.tasks[batch.head++]);
+        batch.size.store(size - 1, std::memory_order_release);
+        return true;
+    }
+    // 从其他消费者的批次中取走一个尚未开始的任务，self 为调用者的编号，不是消费者的线程传 m_batchCount
+    bool StealBatch(size_t self, T& task)
+    {
+        for(size_t i = 1; i <= m_batchCount; ++i)
+        {
+            size_t victim = (self + i) % m_batchCount;
+            if(victim != self && PopBatch(m_batches[victim], task)) return true;
+        }
+        return false;
+    }
+    size_t BatchedSize() const
+    {
+        size_t size = 0;
+        for(size_t i = 0; i < m_batchCount; ++i) size += m_batches[i].size.load(std::memory_order_acquire);
+        return size;
+    }
+
+protected:
+    // 各后端共用：空闲消费者先自旋后停靠，取任务的阻塞部分由派生类按各自的等待方式实现
+    Parker m_parker;
+    std::atomic<bool> m_needStop;
+
+    bool HasWork() const
+    {
+        if(BatchedSize() > 0) return true;
+        if(UseRing())
+        {
+            for (const auto& ring : m_rings)
+            {
+                if(!ring->Empty()) return true;
+            }
+            return false;
+        }
+        if(UseShards()) return m_shards->HasWork();
+        return m_listSize.load(std::memory_order_acquire) > 0;
+    }
+
+    // 不阻塞地从选中的通道取出至多 maxCount 个任务（受公平份额限制），返回取出的数量
+    size_t TryTakeRange(T* out, size_t maxCount, size_t consumers)
+    {
+        if(UseRing())
+        {
+            size_t lane = m_lanes.Pick([this](size_t i){ return !m_rings[i]->Empty(); });
+            if(lane == PriorityLaneCount) return 0;
+            if(size_t count = RingTakeLane(lane, out, maxCount, consumers)) return count;
+            // 选中的通道被其他消费者取空，按优先级依次再试
+            for(size_t i = 0; i < PriorityLaneCount; ++i)
+            {
+                if(size_t count = RingTakeLane(i, out, maxCount, consumers)) return count;
+            }
+            return 0;
+        }
+        if(UseShards()) return m_shards->TryTake(out, maxCount, consumers, m_lanes);
+
+        size_t count = 0;
+        size_t lane = 0;
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            lane = m_lanes.Pick([this](size_t i){ return !m_queues[i].empty(); });
+            if(lane == PriorityLaneCount) return 0;
+            std::list<T>& queue = m_queues[lane];
+            count = FairTakeCount(queue.size(), maxCount, consumers);
+            for(size_t i = 0; i < count; ++i)
+            {
+                out[i] = std::move(queue.front());
+                queue.pop_front();
+            }
+            m_listSize.store(m_listSize.load(std::memory_order_relaxed) - count, std::memory_order_release);
+        }
+        if(count > 1) m_notFull[lane].notify_all();
+        else m_notFull[lane].notify_one();
+        return count;
+    }
+
+    // 消费者 consumer 不阻塞地取一个任务：先取自己批次中剩下的，再从共享通道取一批
+    // （批大小按结果自适应，并受公平份额限制），都没有时从其他消费者的批次中取
+    bool TryTakeFor(size_t consumer, T& task, size_t consumers)
+    {
+        ConsumerBatch& own = m_batches[consumer];
+        if(PopBatch(own, task)) return true;
+
+        size_t count = 0;
+        {
+            // 自己的批次已空，只有所属消费者会放入任务；持有批次锁期间其他消费者不会看到一半的批次
+            std::lock_guard<std::mutex> locker(own.mutex);
+            count = TryTakeRange(own.tasks, own.batchSize, consumers);
+            own.batchSize = NextBatchSize(own.batchSize, count);
+            if(count > 0)
+            {
+                task = std::move(own.tasks[0]);
+                own.head = 1;
+                own.size.store(count - 1, std::memory_order_release);
+            }
+        }
+        if(count > 1) m_parker.NotifyWork(count - 1); // 其余任务可以被空闲消费者取走
+        if(count > 0) return true;
+        return StealBatch(consumer, task);
+    }
+
+public:
+    LaneTaskQueue(size_t maxSize, QueueBackend backend, BackpressurePolicy policy, std::chrono::milliseconds timeout)
+    :m_backend(backend),m_listSize(0),m_highWatermark(0),m_maxSize(maxSize),
+     m_backpressure(policy, timeout),m_needStop(false)
+    {
+        if(m_backend == QueueBackend::RingBuffer)
+        {
+            for(auto& ring : m_rings)
+            {
+                ring = std::make_unique<MpmcRingBuffer<T>>(maxSize);
+            }
+        }
+        else if(m_backend == QueueBackend::Sharded)
+        {
+            m_shards = std::make_unique<ShardedLanes<T>>(DefaultShardCount(), maxSize, m_parker, m_backpressure,
+                                                         m_needStop, m_highWatermark);
+        }
+    }
+    LaneTaskQueue(const LaneTaskQueue&) = delete;
+    LaneTaskQueue& operator=(const LaneTaskQueue&) = delete;
+
+    // 设置消费者数量，编号为 [0, count)；必须在任何消费者开始取任务之前调用
+    void SetConsumerCount(size_t count)
+    {
+        m_batchCount = count;
+        m_batches = count > 0 ? std::make_unique<ConsumerBatch[]>(count) : nullptr;
+    }
+
+    // 返回 OK / STOPPED，或按背压策略返回 TIMEOUT / FULL；未返回 OK 时 task 没有被移动
+    QueueStatus AddTask(T&& task, TaskPriority priority = TaskPriority::Normal)
+    {
+        if(UseRing()) return RingAdd(std::forward<T>(task), LaneIndex(priority));
+        if(UseShards()) return m_shards->Add(std::forward<T>(task), LaneIndex(priority));
+        return Add(std::forward<T>(task), LaneIndex(priority));
+    }
+    QueueStatus AddTask(const T& task, TaskPriority priority = TaskPriority::Normal)
+    {
+        if(UseRing()) return RingAdd(task, LaneIndex(priority));
+        if(UseShards()) return m_shards->Add(task, LaneIndex(priority));
+        return Add(task, LaneIndex(priority));
+    }
+    // 不等待、不丢弃：通道已满时直接返回 FULL，忽略背压策略；未返回 OK 时 task 没有被移动
+    QueueStatus TryAddTask(T&& task, TaskPriority priority = TaskPriority::Normal)
+    {
+        if(UseRing()) return RingAdd(std::forward<T>(task), LaneIndex(priority), false);
+        if(UseShards()) return m_shards->Add(std::forward<T>(task), LaneIndex(priority), false);
+        return Add(std::forward<T>(task), LaneIndex(priority), false);
+    }
+    // 批量放入 [first, last) 中的任务，返回实际放入的数量（队列停止或按背压策略放弃时可能少于区间长度）
+    template<typename It>
+    size_t AddTasks(It first, It last, TaskPriority priority = TaskPriority::Normal)
+    {
+        if(UseRing()) return RingAddRange(first, last, LaneIndex(priority));
+        if(UseShards()) return m_shards->AddRange(first, last, LaneIndex(priority));
+        return AddRange(first, last, LaneIndex(priority));
+    }
+    // 不阻塞地取出一个任务（共享通道为空时取消费者批次中尚未开始的任务），供等待中的线程帮忙执行，没有任务时返回 false
+    bool TryTakeTask(T& task)
+    {
+        return TryTakeRange(&task, 1, 1) > 0 || StealBatch(m_batchCount, task);
+    }
+    // 停止队列，可选择丢弃未处理任务
+    void Stop(bool discardPending = false)
+    {
+        bool expected = false;
+        if (!m_needStop.compare_exchange_strong(expected, true))
+        { return;} // 已经停止，避免重复停止
+
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            if (discardPending)
+            {
+                for(auto& queue : m_queues) queue.clear();
+                m_listSize.store(0, std::memory_order_release);
+            }
+        }
+        for(auto& cond : m_notFull) cond.notify_all();
+        if(UseShards()) m_shards->Stop(discardPending);
+        if(discardPending)
+        {
+            T task;
+            for(size_t i = 0; i < m_batchCount; ++i)
+            {
+                while(PopBatch(m_batches[i], task)) task = T(); // 在批次锁之外析构
+            }
+        }
+
+        if(UseRing())
+        {
+            for(size_t lane = 0; lane < PriorityLaneCount; ++lane)
+            {
+                if(discardPending)
+                {
+                    T task;
+                    while(m_rings[lane]->TryPop(task)) {}
+                }
+                m_ringNotFull[lane].NotifyAll();
+            }
+        }
+        m_parker.NotifyAll();
+    }
+
+    // 通道满时的处理方式，可在运行中修改
+    Backpressure& GetBackpressure()
+    {
+        return m_backpressure;
+    }
+    const Backpressure& GetBackpressure() const
+    {
+        return m_backpressure;
+    }
+
+    // 老化阈值：低优先级通道被连续跳过这么多次后优先服务一次，0 表示严格按优先级
+    void SetAgingThreshold(uint32_t threshold)
+    {
+        m_lanes.SetAgingThreshold(threshold);
+    }
+
+    QueueBackend Backend() const
+    {
+        return m_backend;
+    }
+    bool Empty() const
+    {
+        return !HasWork();
+    }
+    // 任一通道已满
+    bool Full() const
+    {
+        if(UseRing())
+        {
+            for(const auto& ring : m_rings)
+            {
+                if(ring->Full()) return true;
+            }
+            return false;
+        }
+        if(UseShards()) return m_shards->Full();
+        std::lock_guard<std::mutex> locker(m_mutex);
+        for(size_t lane = 0; lane < PriorityLaneCount; ++lane)
+        {
+            if(IsFull(lane)) return true;
+        }
+        return false;
+    }
+    // 排队中的任务数，包括各消费者批次中尚未开始的任务
+    size_t Size() const
+    {
+        if(UseRing()) return RingSize() + BatchedSize();
+        if(UseShards()) return m_shards->Size() + BatchedSize();
+        return m_listSize.load(std::memory_order_acquire) + BatchedSize();
+    }
+    // 指定优先级通道中的任务数，不含已经取进消费者批次的任务
+    size_t Size(TaskPriority priority) const
+    {
+        size_t lane = LaneIndex(priority);
+        if(UseRing()) return m_rings[lane]->Size();
+        if(UseShards()) return m_shards->Size(lane);
+        std::lock_guard<std::mutex> locker(m_mutex);
+        return m_queues[lane].size();
+    }
+    // 自创建以来单条通道长度的最大值
+    size_t HighWatermark() const
+    {
+        return m_highWatermark.load(std::memory_order_relaxed);
+    }
+    // 正在自旋 / 已睡眠的空闲消费者数量
+    uint32_t Spinning() const
+    {
+        return m_parker.Spinning();
+    }
+    uint32_t Sleeping() const
+    {
+        return m_parker.Sleeping();
+    }
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "SyncQueueCommon.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// 有界多生产者多消费者无锁环形队列（基于每个槽位的序号）
+// 槽位序号 == 下标 时可写，== 下标 + 1 时可读；入队和出队各只需一次 CAS，不加锁也不分配内存
+// 入队/出队位置分别独占缓存行，生产者与消费者之间不会伪共享
+// 槽位数向上取整为 2 的幂，但可容纳的任务数严格等于构造时指定的容量：
+// 容量不是 2 的幂时入队额外比较一次已占用的槽位数，是 2 的幂时只靠槽位序号判断，没有额外开销
+template<typename T>
+class MpmcRingBuffer
+{
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* Ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    alignas(CacheLineSize) std::atomic<size_t> m_enqueuePos;
+    alignas(CacheLineSize) std::atomic<size_t> m_dequeuePos;
+    alignas(CacheLineSize) std::unique_ptr<Cell[]> m_cells;
+    size_t m_capacity; // 可容纳的任务数
+    size_t m_mask;     // 槽位数 - 1
+
+    static size_t RoundUpPow2(size_t n)
+    {
+        size_t cap = 2;
+        while (cap < n) cap <<= 1;
+        return cap;
+    }
+
+public:
+    explicit MpmcRingBuffer(size_t capacity)
+        : m_enqueuePos(0),
+          m_dequeuePos(0),
+          m_capacity(capacity > 0 ? capacity : 1),
+          m_mask(RoundUpPow2(m_capacity) - 1)
+    {
+        m_cells.reset(new Cell[m_mask + 1]);
+        for (size_t i = 0; i <= m_mask; ++i)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    ~MpmcRingBuffer()
+    {
+        T task;
+        while (TryPop(task)) {}
+    }
+    MpmcRingBuffer(const MpmcRingBuffer&) = delete;
+    MpmcRingBuffer& operator=(const MpmcRingBuffer&) = delete;
+
+    // 队列满时返回 false 且不移动 task
+    template<typename F>
+    bool TryPush(F&& task)
+    {
+        Cell* cell;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                // 出队位置只增不减，读到旧值只会高估占用数；pos 已过期时 used 可能为负，CAS 失败后重试
+                if (m_capacity <= m_mask)
+                {
+                    intptr_t used = static_cast<intptr_t>(pos - m_dequeuePos.load(std::memory_order_acquire));
+                    if (used >= static_cast<intptr_t>(m_capacity)) return false;
+                }
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                return false; // 槽位还未被消费，队列已满
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        ::new (static_cast<void*>(cell->storage)) T(std::forward<F>(task));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 队列空时返回 false
+    bool TryPop(T& task)
+    {
+        Cell* cell;
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                return false; // 槽位还未被写入，队列为空
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        task = std::move(*cell->Ptr());
+        cell->Ptr()->~T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 近似值，并发修改时仅作参考
+    size_t Size() const
+    {
+        size_t tail = m_enqueuePos.load(std::memory_order_acquire);
+        size_t head = m_dequeuePos.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+    bool Empty() const
+    {
+        return Size() == 0;
+    }
+    bool Full() const
+    {
+        return Size() >= m_capacity;
+    }
+    size_t Capacity() const
+    {
+        return m_capacity;
+    }
+};
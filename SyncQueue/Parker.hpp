@@ -0,0 +1,135 @@
+#pragma once
+
+#include "EventCount.hpp"
+#include "SyncQueueCommon.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// 空闲线程停靠器，三种线程池的队列共用
+// 取不到任务的线程先自旋一小段时间，仍然没有任务才在 EventCount 上睡眠；
+// 生产者只在没有线程自旋找任务时才唤醒睡眠线程，并且一次只唤醒与任务数相当的线程，
+// 避免每次提交都进内核以及惊群
+// 自旋次数按结果自适应：自旋期间拿到任务就加倍，白白自旋就减半
+// 同时自旋的线程数有上限（默认为 CPU 核数的一半），单核机器上不自旋
+class Parker
+{
+private:
+    static constexpr uint32_t MinSpin = 32;
+    static constexpr uint32_t MaxSpin = 4096;
+
+    EventCount m_event;
+    alignas(CacheLineSize) std::atomic<uint32_t> m_spinning;
+    std::atomic<uint32_t> m_spinLimit;
+    uint32_t m_maxSpinners;
+
+    static uint32_t DefaultMaxSpinners()
+    {
+        return std::thread::hardware_concurrency() / 2;
+    }
+
+    // 自旋等待任务，拿到任务返回 true
+    template<typename TryTake, typename HasWork>
+    bool Spin(TryTake& tryTake, HasWork& hasWork, const std::atomic<bool>& stop)
+    {
+        if (m_spinning.load(std::memory_order_relaxed) >= m_maxSpinners) return false;
+        m_spinning.fetch_add(1, std::memory_order_seq_cst);
+
+        uint32_t limit = m_spinLimit.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < limit && !stop.load(std::memory_order_relaxed); ++i)
+        {
+            if (hasWork() && tryTake())
+            {
+                bool lastSpinner = m_spinning.fetch_sub(1, std::memory_order_seq_cst) == 1;
+                m_spinLimit.store(std::min(limit * 2, MaxSpin), std::memory_order_relaxed);
+                // 最后一个自旋线程拿走任务后，生产者可能因为看到有人自旋而没有唤醒别人，
+                // 若还有剩余任务则补一次唤醒
+                if (lastSpinner && hasWork()) m_event.NotifyOne();
+                return true;
+            }
+            CpuRelax();
+        }
+        m_spinning.fetch_sub(1, std::memory_order_seq_cst);
+        m_spinLimit.store(std::max(limit / 2, MinSpin), std::memory_order_relaxed);
+        return false;
+    }
+
+public:
+    explicit Parker(uint32_t maxSpinners = DefaultMaxSpinners())
+        : m_spinning(0),
+          m_spinLimit(MinSpin * 4),
+          m_maxSpinners(maxSpinners)
+    {}
+    Parker(const Parker&) = delete;
+    Parker& operator=(const Parker&) = delete;
+
+    // 消费者：反复尝试 tryTake，先自旋后睡眠，直到拿到任务（OK）、停止且无任务（STOPPED）或超时（TIMEOUT）
+    // hasWork 必须是廉价的无锁检查，tryTake 成功时必须已经取出任务
+    template<typename TryTake, typename HasWork, typename Clock, typename Duration>
+    QueueStatus Park(TryTake&& tryTake,
+                     HasWork&& hasWork,
+                     const std::atomic<bool>& stop,
+                     const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        while (true)
+        {
+            if (tryTake()) return QueueStatus::OK;
+            if (stop.load()) return QueueStatus::STOPPED;
+            if (Spin(tryTake, hasWork, stop)) return QueueStatus::OK;
+
+            // 登记为等待者后再检查一次，避免与生产者之间丢失唤醒
+            auto key = m_event.PrepareWait();
+            if (stop.load() || hasWork())
+            {
+                m_event.CancelWait();
+                continue;
+            }
+            if (!m_event.Wait(key, deadline)) return QueueStatus::TIMEOUT;
+        }
+    }
+    template<typename TryTake, typename HasWork>
+    QueueStatus Park(TryTake&& tryTake, HasWork&& hasWork, const std::atomic<bool>& stop)
+    {
+        return Park(tryTake, hasWork, stop, std::chrono::steady_clock::time_point::max());
+    }
+
+    // 生产者：发布 count 个任务之后调用
+    void NotifyWork(size_t count = 1)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t spinning = m_spinning.load(std::memory_order_relaxed);
+        if (spinning >= count) return; // 自旋中的线程会拿走这些任务
+        m_event.NotifyN(count - spinning);
+    }
+    void NotifyAll()
+    {
+        m_event.NotifyAll();
+    }
+
+    uint32_t Spinning() const
+    {
+        return m_spinning.load(std::memory_order_relaxed);
+    }
+    uint32_t Sleeping() const
+    {
+        return m_event.Waiters();
+    }
+};
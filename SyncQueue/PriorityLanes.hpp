@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 任务优先级，数值越小越优先
+enum class TaskPriority
+{
+    High = 0,   // 延迟敏感的交互任务
+    Normal = 1, // 未指定优先级的任务
+    Low = 2     // 后台批量任务
+};
+
+inline constexpr size_t PriorityLaneCount = 3;
+
+// 默认老化阈值：某条非空通道连续被更高优先级通道跳过这么多次后，下一次优先服务它
+inline constexpr uint32_t DefaultAgingThreshold = 16;
+
+inline size_t LaneIndex(TaskPriority priority)
+{
+    size_t lane = static_cast<size_t>(priority);
+    return lane < PriorityLaneCount ? lane : PriorityLaneCount - 1;
+}
+
+// 多条优先级通道之间的选择：总是先服务优先级最高的非空通道，
+// 开启老化时，被跳过次数达到阈值的低优先级通道会被提前服务一次，避免饿死
+// 计数只用 relaxed 原子操作，无锁后端上并发选择时老化是近似的，但不会丢失任务
+class LaneScheduler
+{
+private:
+    std::atomic<uint32_t> m_skipped[PriorityLaneCount];
+    std::atomic<uint32_t> m_agingThreshold; // 为 0 时严格按优先级
+
+public:
+    explicit LaneScheduler(uint32_t agingThreshold = DefaultAgingThreshold)
+        : m_agingThreshold(agingThreshold)
+    {
+        for (auto& skipped : m_skipped) skipped.store(0, std::memory_order_relaxed);
+    }
+
+    void SetAgingThreshold(uint32_t threshold)
+    {
+        m_agingThreshold.store(threshold, std::memory_order_relaxed);
+    }
+    uint32_t AgingThreshold() const
+    {
+        return m_agingThreshold.load(std::memory_order_relaxed);
+    }
+
+    // nonEmpty(lane) 判断通道是否有任务，返回本次应服务的通道，全部为空时返回 PriorityLaneCount
+    template<typename NonEmpty>
+    size_t Pick(NonEmpty&& nonEmpty)
+    {
+        bool ready[PriorityLaneCount];
+        size_t chosen = PriorityLaneCount;
+        for (size_t lane = 0; lane < PriorityLaneCount; ++lane)
+        {
+            ready[lane] = nonEmpty(lane);
+            if (ready[lane] && chosen == PriorityLaneCount) chosen = lane;
+        }
+        if (chosen == PriorityLaneCount) return chosen;
+
+        uint32_t threshold = m_agingThreshold.load(std::memory_order_relaxed);
+        if (threshold > 0)
+        {
+            for (size_t lane = chosen + 1; lane < PriorityLaneCount; ++lane)
+            {
+                if (ready[lane] && m_skipped[lane].load(std::memory_order_relaxed) >= threshold)
+                {
+                    chosen = lane;
+                    break;
+                }
+            }
+            for (size_t lane = chosen + 1; lane < PriorityLaneCount; ++lane)
+            {
+                if (ready[lane]) m_skipped[lane].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        m_skipped[chosen].store(0, std::memory_order_relaxed);
+        return chosen;
+    }
+};
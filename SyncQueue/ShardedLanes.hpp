@@ -0,0 +1,366 @@
+#pragma once
+
+#include "Backpressure.hpp"
+#include "Parker.hpp"
+#include "PriorityLanes.hpp"
+#include "SyncQueueCommon.hpp"
+#include "WorkerCounters.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// QueueBackend::Sharded 的存储：若干个分片，每个分片有自己的锁和一组优先级通道
+// 生产者按 SubmitShard 选择分片，先用 try_lock 试本分片和下一个分片，都被占用时换分片并直接加锁寻找空位，
+// 所有分片都满时才在本分片上按背压策略处理；消费者从 HomeShard 开始扫描，各自优先访问不同的分片
+// 总容量按分片数均分给各分片的每条通道，余数分给前几个分片，同一条通道在所有分片上的容量之和等于总容量；
+// 总容量小于分片数时减少分片数，每个分片至少能放一个任务。通道之间的优先级由调用者的 LaneScheduler 决定
+template<typename T>
+class ShardedLanes
+{
+private:
+    struct alignas(CacheLineSize) Shard
+    {
+        Shard() : waitingProducers(0)
+        {
+            for (auto& size : sizes) size.store(0, std::memory_order_relaxed);
+        }
+
+        std::mutex mutex;
+        std::condition_variable notFull;
+        std::deque<T> lanes[PriorityLaneCount];
+        std::atomic<size_t> sizes[PriorityLaneCount]; // 无锁读取各通道长度，避免空分片上加锁
+        size_t waitingProducers;                      // 受 mutex 保护
+        size_t capacity = 1;                          // 每条通道的容量，构造后不变
+    };
+
+    enum class PushResult
+    {
+        Ok,
+        Busy,
+        Full,
+        Stopped
+    };
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    Parker& m_parker;
+    Backpressure& m_backpressure;
+    const std::atomic<bool>& m_needStop;
+    std::atomic<size_t>& m_highWatermark;
+
+    // 持有分片锁时调用；历史最大长度按通道在所有分片上的合计统计，与其他后端的单条通道含义一致
+    template<typename F>
+    void PushLocked(Shard& shard, size_t lane, F&& task)
+    {
+        std::deque<T>& queue = shard.lanes[lane];
+        queue.emplace_back(std::forward<F>(task));
+        shard.sizes[lane].store(queue.size(), std::memory_order_release);
+        UpdateHighWatermark(m_highWatermark, Size(lane));
+    }
+    T PopLocked(Shard& shard, size_t lane)
+    {
+        std::deque<T>& queue = shard.lanes[lane];
+        T task = std::move(queue.front());
+        queue.pop_front();
+        shard.sizes[lane].store(queue.size(), std::memory_order_release);
+        return task;
+    }
+
+    // wait 为 false 时只尝试 try_lock；未返回 Ok 时 task 没有被移动
+    template<typename F>
+    PushResult TryPush(F&& task, size_t lane, size_t index, bool wait)
+    {
+        Shard& shard = *m_shards[index];
+        if (shard.sizes[lane].load(std::memory_order_relaxed) >= shard.capacity) return PushResult::Full;
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex, std::defer_lock);
+            if (wait) lock.lock();
+            else if (!lock.try_lock()) return PushResult::Busy;
+            if (m_needStop.load()) return PushResult::Stopped;
+            if (shard.lanes[lane].size() >= shard.capacity) return PushResult::Full;
+            PushLocked(shard, lane, std::forward<F>(task));
+        }
+        m_parker.NotifyWork();
+        return PushResult::Ok;
+    }
+
+    // 所有分片都满：在 index 分片上按背压策略等待、丢弃最早的任务或返回 FULL，被丢弃的任务在释放锁之后才析构
+    template<typename F>
+    QueueStatus PushWithBackpressure(F&& task, size_t lane, size_t index)
+    {
+        Shard& shard = *m_shards[index];
+        T dropped;
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            if (!m_needStop.load() && shard.lanes[lane].size() >= shard.capacity)
+            {
+                if (m_backpressure.Policy() == BackpressurePolicy::DropOldest)
+                {
+                    dropped = PopLocked(shard, lane);
+                    m_backpressure.RecordDropped();
+                }
+                else if (!m_backpressure.Waits())
+                {
+                    return QueueStatus::FULL;
+                }
+                else
+                {
+                    ++shard.waitingProducers;
+                    bool ready = Backpressure::Wait(
+                        shard.notFull, lock, m_backpressure.Deadline(),
+                        [this, &shard, lane]
+                        {
+                            return m_needStop.load() || shard.lanes[lane].size() < shard.capacity;
+                        });
+                    --shard.waitingProducers;
+                    if (!ready) return QueueStatus::TIMEOUT;
+                }
+            }
+            if (m_needStop.load()) return QueueStatus::STOPPED;
+            PushLocked(shard, lane, std::forward<F>(task));
+        }
+        m_parker.NotifyWork();
+        return QueueStatus::OK;
+    }
+
+    // 持有分片锁时把 [first, last) 放入通道直到放满，返回放入的数量
+    template<typename It>
+    size_t FillLocked(Shard& shard, size_t lane, It& first, It last)
+    {
+        std::deque<T>& queue = shard.lanes[lane];
+        size_t batch = 0;
+        for (; first != last && queue.size() < shard.capacity; ++first, ++batch)
+        {
+            queue.emplace_back(*first);
+        }
+        shard.sizes[lane].store(queue.size(), std::memory_order_release);
+        UpdateHighWatermark(m_highWatermark, Size(lane));
+        return batch;
+    }
+
+    size_t TakeLane(size_t lane, T* out, size_t maxCount, size_t consumers)
+    {
+        size_t count = m_shards.size();
+        size_t start = HomeShard(count);
+        // 每个分片由大约 consumers / 分片数 个消费者竞争
+        size_t perShard = consumers > count ? consumers / count : 1;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Shard& shard = *m_shards[(start + i) % count];
+            if (shard.sizes[lane].load(std::memory_order_acquire) == 0) continue;
+
+            size_t taken = 0;
+            bool notify = false;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                std::deque<T>& queue = shard.lanes[lane];
+                if (queue.empty()) continue;
+                taken = FairTakeCount(queue.size(), maxCount, perShard);
+                for (size_t k = 0; k < taken; ++k)
+                {
+                    out[k] = std::move(queue.front());
+                    queue.pop_front();
+                }
+                shard.sizes[lane].store(queue.size(), std::memory_order_release);
+                notify = shard.waitingProducers > 0;
+            }
+            if (notify)
+            {
+                if (taken > 1) shard.notFull.notify_all();
+                else shard.notFull.notify_one();
+            }
+            return taken;
+        }
+        return 0;
+    }
+
+public:
+    ShardedLanes(size_t shardCount, size_t maxSize, Parker& parker, Backpressure& backpressure,
+                 const std::atomic<bool>& needStop, std::atomic<size_t>& highWatermark)
+        : m_parker(parker),
+          m_backpressure(backpressure),
+          m_needStop(needStop),
+          m_highWatermark(highWatermark)
+    {
+        if (maxSize == 0) maxSize = 1;
+        shardCount = std::max<size_t>(1, std::min(shardCount, maxSize));
+        m_shards.reserve(shardCount);
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            m_shards.emplace_back(std::make_unique<Shard>());
+            m_shards.back()->capacity = maxSize / shardCount + (i < maxSize % shardCount ? 1 : 0);
+        }
+    }
+
+    // 返回 OK / STOPPED，或按背压策略返回 TIMEOUT / FULL；applyBackpressure 为 false 时所有分片都满直接返回 FULL
+    // 未返回 OK 时 task 没有被移动
+    template<typename F>
+    QueueStatus Add(F&& task, size_t lane, bool applyBackpressure = true)
+    {
+        size_t count = m_shards.size();
+        size_t home = SubmitShard(count);
+        for (size_t probe = 0; probe < count; ++probe)
+        {
+            // 前两个分片只 try_lock，之后的分片直接加锁，只是在寻找空位
+            PushResult result = TryPush(std::forward<F>(task), lane, (home + probe) % count, probe >= 2);
+            if (result == PushResult::Ok)
+            {
+                if (probe > 0) SkipSubmitShard(probe);
+                return QueueStatus::OK;
+            }
+            if (result == PushResult::Stopped) return QueueStatus::STOPPED;
+        }
+        if (!applyBackpressure) return QueueStatus::FULL;
+        return PushWithBackpressure(std::forward<F>(task), lane, home);
+    }
+
+    // 依次填满各分片的空位，全部放满后在起始分片上按背压策略等待或丢弃最早的任务；
+    // Reject / CallerRuns 时停在第一个放不下的任务。返回实际放入的数量
+    template<typename It>
+    size_t AddRange(It first, It last, size_t lane)
+    {
+        size_t count = m_shards.size();
+        size_t home = SubmitShard(count);
+        size_t added = 0;
+        for (size_t probe = 0; probe < count && first != last; ++probe)
+        {
+            Shard& shard = *m_shards[(home + probe) % count];
+            size_t batch = 0;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (m_needStop.load()) return added;
+                batch = FillLocked(shard, lane, first, last);
+            }
+            added += batch;
+            m_parker.NotifyWork(batch);
+        }
+
+        Shard& shard = *m_shards[home];
+        std::vector<T> dropped;
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        auto deadline = m_backpressure.Deadline();
+        while (first != last)
+        {
+            if (!m_needStop.load() && shard.lanes[lane].size() >= shard.capacity)
+            {
+                if (m_backpressure.Policy() == BackpressurePolicy::DropOldest)
+                {
+                    dropped.emplace_back(PopLocked(shard, lane));
+                    m_backpressure.RecordDropped();
+                }
+                else
+                {
+                    if (!m_backpressure.Waits()) break;
+                    ++shard.waitingProducers;
+                    bool ready = Backpressure::Wait(
+                        shard.notFull, lock, deadline,
+                        [this, &shard, lane]
+                        {
+                            return m_needStop.load() || shard.lanes[lane].size() < shard.capacity;
+                        });
+                    --shard.waitingProducers;
+                    if (!ready) break;
+                }
+            }
+            if (m_needStop.load()) break;
+
+            size_t batch = FillLocked(shard, lane, first, last);
+            added += batch;
+
+            lock.unlock();
+            m_parker.NotifyWork(batch);
+            lock.lock();
+        }
+        lock.unlock();
+        return added;
+    }
+
+    // 不阻塞地从 lanes 选中的通道取出至多 maxCount 个任务，一批任务来自同一个分片的同一条通道
+    size_t TryTake(T* out, size_t maxCount, size_t consumers, LaneScheduler& lanes)
+    {
+        size_t lane = lanes.Pick([this](size_t i){ return Size(i) > 0; });
+        if (lane == PriorityLaneCount) return 0;
+        if (size_t count = TakeLane(lane, out, maxCount, consumers)) return count;
+        // 选中的通道被其他消费者取空，按优先级依次再试
+        for (size_t i = 0; i < PriorityLaneCount; ++i)
+        {
+            if (size_t count = TakeLane(i, out, maxCount, consumers)) return count;
+        }
+        return 0;
+    }
+
+    // 唤醒所有等待空位的生产者，可选择丢弃未处理任务
+    void Stop(bool discardPending)
+    {
+        for (auto& shard : m_shards)
+        {
+            std::deque<T> discarded[PriorityLaneCount];
+            {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                if (discardPending)
+                {
+                    for (size_t lane = 0; lane < PriorityLaneCount; ++lane)
+                    {
+                        discarded[lane].swap(shard->lanes[lane]);
+                        shard->sizes[lane].store(0, std::memory_order_release);
+                    }
+                }
+            }
+            shard->notFull.notify_all();
+        }
+    }
+
+    size_t ShardCount() const
+    {
+        return m_shards.size();
+    }
+    size_t Size(size_t lane) const
+    {
+        size_t size = 0;
+        for (const auto& shard : m_shards)
+        {
+            size += shard->sizes[lane].load(std::memory_order_acquire);
+        }
+        return size;
+    }
+    size_t Size() const
+    {
+        size_t size = 0;
+        for (size_t lane = 0; lane < PriorityLaneCount; ++lane) size += Size(lane);
+        return size;
+    }
+    bool HasWork() const
+    {
+        for (const auto& shard : m_shards)
+        {
+            for (const auto& size : shard->sizes)
+            {
+                if (size.load(std::memory_order_acquire) > 0) return true;
+            }
+        }
+        return false;
+    }
+    // 某条通道在所有分片上都已放满，再提交就要按背压策略处理
+    bool Full() const
+    {
+        for (size_t lane = 0; lane < PriorityLaneCount; ++lane)
+        {
+            bool full = true;
+            for (const auto& shard : m_shards)
+            {
+                if (shard->sizes[lane].load(std::memory_order_acquire) < shard->capacity)
+                {
+                    full = false;
+                    break;
+                }
+            }
+            if (full) return true;
+        }
+        return false;
+    }
+};
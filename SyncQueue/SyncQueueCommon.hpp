@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+
+enum class QueueStatus
+{
+    OK = 0,
+    TIMEOUT = 1,
+    STOPPED = 2,
+    FULL = 3     // 队列已满且背压策略不等待，任务未放入也未被移动
+};
+
+// 有界任务队列的存储后端
+enum class QueueBackend
+{
+    List = 0,       // std::list + 互斥锁，每个任务一次节点分配
+    RingBuffer = 1, // 预分配的无锁 MPMC 环形队列，容量向上取整为 2 的幂
+    Sharded = 2     // 按 CPU 数量划分的多个分片，每个分片一把锁，生产者按线程分散提交，消费者从各分片取任务
+};
+
+// 缓存行大小，高频读写的原子变量按此对齐，避免伪共享
+inline constexpr size_t CacheLineSize = 64;
+
+// 批量提交需要先计数再遍历区间，只接受可以多次遍历的前向迭代器
+template<typename It>
+inline constexpr bool IsForwardIterator =
+    std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>;
+
+// 工作线程一次批量取出任务的上限
+inline constexpr size_t MaxTakeBatch = 16;
+
+// 公平份额：一次最多取走 queued / consumers 个任务（至少 1 个），避免单个线程囤积整批突发任务
+inline size_t FairTakeCount(size_t queued, size_t maxCount, size_t consumers)
+{
+    size_t share = consumers > 1 ? queued / consumers : queued;
+    if (share == 0) share = 1;
+    return share < maxCount ? share : maxCount;
+}
+
+// 自适应批大小：取满则翻倍，取到不足一半则减半
+inline size_t NextBatchSize(size_t current, size_t taken)
+{
+    if (taken >= current) return current * 2 <= MaxTakeBatch ? current * 2 : MaxTakeBatch;
+    if (taken < current / 2) return current / 2 > 0 ? current / 2 : 1;
+    return current;
+}
+
+// 分片提交：每个线程首次使用时领取一个序号作为起始分片，之后只修改自己的线程局部状态，
+// 生产者之间不共享任何缓存行。连续 SubmitShardSpan 次提交落在同一分片后换到下一个，
+// 单个生产者的任务也会分散到各个分片
+inline constexpr size_t SubmitShardSpan = 16;
+
+// 分片数量的上限，超过后增加分片对减少竞争没有明显帮助，消费者扫描的开销却线性增长
+inline constexpr size_t MaxSubmitShards = 16;
+
+inline size_t DefaultShardCount()
+{
+    size_t cpus = std::thread::hardware_concurrency();
+    if (cpus == 0) cpus = 1;
+    return cpus < MaxSubmitShards ? cpus : MaxSubmitShards;
+}
+
+struct SubmitCursor
+{
+    size_t ordinal; // 线程序号，作为消费者扫描的固定起点
+    size_t shard;
+    size_t count;
+};
+
+inline SubmitCursor& LocalSubmitCursor()
+{
+    static std::atomic<size_t> nextOrdinal{0};
+    static thread_local SubmitCursor cursor = [] {
+        size_t ordinal = nextOrdinal.fetch_add(1, std::memory_order_relaxed);
+        return SubmitCursor{ordinal, ordinal, 0};
+    }();
+    return cursor;
+}
+
+// 本次提交使用的分片
+inline size_t SubmitShard(size_t shardCount)
+{
+    SubmitCursor& cursor = LocalSubmitCursor();
+    if (++cursor.count >= SubmitShardSpan)
+    {
+        cursor.count = 0;
+        ++cursor.shard;
+    }
+    return cursor.shard % shardCount;
+}
+
+// 当前分片竞争激烈或已满，下次提交换到另一个分片
+inline void SkipSubmitShard(size_t skipped)
+{
+    SubmitCursor& cursor = LocalSubmitCursor();
+    cursor.shard += skipped;
+    cursor.count = 0;
+}
+
+// 消费者取任务时扫描分片的起点，同一线程固定不变
+inline size_t HomeShard(size_t shardCount)
+{
+    return LocalSubmitCursor().ordinal % shardCount;
+}
@@ -1,105 +1,314 @@
 #pragma once
+#include "Backpressure.hpp"
+#include "ChaseLevDeque.hpp"
+#include "Parker.hpp"
+#include "SyncQueueCommon.hpp"
+#include "WorkerCounters.hpp"
+
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <utility>
 #include <vector>
 
-enum class QueueStatus
-{
-    OK = 0,
-    TIMEOUT = 1,
-    STOPPED = 2
-};
-
 // 为工作窃取线程池准备的多桶队列，每个线程拥有自己的队列，空闲时可从其他桶窃取
+// 每个桶由两部分组成：
+//   local：Chase-Lev 双端队列，拥有者无锁 push/pop，其他线程从顶部窃取
+//   inbox：外部线程提交任务的入口，只有该桶自己的互斥锁，不同桶之间互不竞争
+// 空闲线程通过 Parker 先自旋后睡眠，生产者只在没有线程自旋且确实有人睡眠时才进入内核唤醒
 template<typename T>
-class SyncQueue
+class WorkStealingSyncQueue
 {
 private:
-    std::vector<std::deque<T>> m_queues;
+    struct alignas(CacheLineSize) Bucket
+    {
+        explicit Bucket(size_t capacity) : local(capacity), inboxSize(0), waitingProducers(0), highWatermark(0) {}
+
+        ChaseLevDeque<T> local;
+        std::mutex inboxMutex;
+        std::condition_variable notFull;
+        std::deque<T> inbox;
+        std::atomic<size_t> inboxSize; // 无锁读取 inbox 长度，避免空桶上加锁
+        size_t waitingProducers;       // 受 inboxMutex 保护
+        std::atomic<size_t> highWatermark; // local 与 inbox 合计长度的历史最大值
+
+        size_t Depth() const
+        {
+            return local.Size() + inboxSize.load(std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::unique_ptr<Bucket>> m_buckets;
     size_t m_maxsize;      // 每个桶的最大容量
     size_t m_bucketCount;
-    size_t m_waitTime;     // wait_for 的超时时间（秒）
+    Backpressure m_backpressure; // inbox 满时的处理方式，默认至多等待 waitTime 秒
 
-    mutable std::mutex m_mutex;
-    std::condition_variable m_notEmpty;
-    std::condition_variable m_notFull;
+    Parker m_parker;
     std::atomic<bool> m_needStop;
+    std::vector<std::vector<size_t>> m_stealOrder; // 每个桶的窃取顺序，为空时从随机位置开始扫描
+    bool m_stealHalf;                              // 一次窃取受害者约一半的任务
 
-    bool IsFull(const size_t index) const
+    static constexpr size_t MaxStealBatch = 32; // 一次批量窃取额外搬运的任务上限
+
+    // 每个线程独立的 xorshift 随机数，用于选择窃取起点
+    static uint64_t NextRandom()
     {
-        return m_queues[index].size() >= m_maxsize;
+        static thread_local uint64_t state =
+            reinterpret_cast<uintptr_t>(&state) ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^ 0x9E3779B97F4A7C15ull;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
     }
-    bool IsEmpty(const size_t index) const
+
+    bool PopFromOwn(size_t bucket, T& task)
     {
-        return m_queues[index].empty();
+        return m_buckets[bucket]->local.Pop(task); // 自己使用后进先出，提升缓存局部性
     }
-    size_t TotalSizeUnsafe() const
+    // 批量窃取时多取到的任务放入窃取者自己的本地队列，其他空闲线程可以继续从这里窃取；
+    // 本地队列满时退回窃取者自己的 inbox
+    void KeepLocal(size_t thief, T& task)
     {
-        size_t size = 0;
-        for (const auto& q : m_queues)
+        Bucket& b = *m_buckets[thief];
+        if (b.local.Push(std::move(task))) return;
+        std::lock_guard<std::mutex> lock(b.inboxMutex);
+        b.inbox.emplace_back(std::move(task));
+        b.inboxSize.store(b.inbox.size(), std::memory_order_release);
+    }
+    // 从 bucket 的 inbox 取出任务，返回取出的数量；thief 为调用者自己的桶（外部线程为越界下标）
+    // 开启批量窃取时额外搬运至多一半的任务到 thief 的本地队列，一次加锁取走多个任务
+    size_t TakeFromInbox(size_t bucket, T& task, size_t thief)
+    {
+        Bucket& b = *m_buckets[bucket];
+        if (b.inboxSize.load(std::memory_order_acquire) == 0) return 0;
+
+        size_t taken = 0;
+        bool notify = false;
         {
-            size += q.size();
+            std::lock_guard<std::mutex> lock(b.inboxMutex);
+            if (b.inbox.empty()) return 0;
+            task = std::move(b.inbox.front()); // inbox 按提交顺序先进先出
+            b.inbox.pop_front();
+            taken = 1;
+            if (m_stealHalf && thief < m_bucketCount)
+            {
+                // 持有 inbox 锁时只做无锁的本地压入，压不进去就停止，避免再去锁自己的 inbox
+                ChaseLevDeque<T>& own = m_buckets[thief]->local;
+                size_t extra = std::min(b.inbox.size() / 2, MaxStealBatch);
+                for (; extra > 0 && own.Push(std::move(b.inbox.front())); --extra, ++taken)
+                {
+                    b.inbox.pop_front();
+                }
+            }
+            b.inboxSize.store(b.inbox.size(), std::memory_order_release);
+            notify = b.waitingProducers > 0;
         }
-        return size;
+        if (notify)
+        {
+            if (taken > 1) b.notFull.notify_all();
+            else b.notFull.notify_one();
+        }
+        return taken;
     }
-
-    bool PopFromOwn(size_t bucket, T& task)
+    size_t StealFrom(size_t victim, T& task, size_t thief)
     {
-        if (m_queues[bucket].empty()) return false;
-        task = std::move(m_queues[bucket].back()); // 自己使用后进先出，提升缓存局部性
-        m_queues[bucket].pop_back();
-        return true;
+        ChaseLevDeque<T>& deque = m_buckets[victim]->local;
+        if (!deque.Steal(task)) return TakeFromInbox(victim, task, thief); // 窃取使用先进先出，减少竞争
+
+        size_t taken = 1;
+        if (m_stealHalf && thief < m_bucketCount)
+        {
+            // Chase-Lev 窃取者只能逐个 CAS 顶部，因此批量窃取是连续的单个窃取，
+            // 收益在于之后这些任务都在本地执行，不必反复扫描受害者
+            size_t extra = std::min(deque.Size() / 2, MaxStealBatch);
+            T extraTask;
+            for (; extra > 0 && deque.Steal(extraTask); --extra, ++taken)
+            {
+                KeepLocal(thief, extraTask);
+            }
+        }
+        return taken;
     }
-    bool StealFromOthers(size_t bucket, T& task)
+    size_t StealFromOthers(size_t bucket, T& task)
     {
+        if (bucket < m_stealOrder.size())
+        {
+            for (size_t victim : m_stealOrder[bucket])
+            {
+                if (size_t taken = StealFrom(victim, task, bucket)) return taken;
+            }
+            return 0;
+        }
+        // 从随机位置开始轮转扫描，避免所有窃取者都挤向下标最小的忙碌线程
+        size_t start = static_cast<size_t>(NextRandom() % m_bucketCount);
         for (size_t i = 0; i < m_bucketCount; ++i)
         {
-            if (i == bucket || m_queues[i].empty()) continue;
-            task = std::move(m_queues[i].front()); // 窃取使用先进先出，减少竞争
-            m_queues[i].pop_front();
-            return true;
+            size_t victim = (start + i) % m_bucketCount;
+            if (victim == bucket) continue;
+            if (size_t taken = StealFrom(victim, task, bucket)) return taken;
+        }
+        return 0;
+    }
+    // counters 非空时记录窃取统计，只能由 bucket 对应的工作线程传入
+    bool TryTake(T& task, size_t bucket, WorkerCounters* counters)
+    {
+        if (bucket < m_bucketCount)
+        {
+            if (PopFromOwn(bucket, task)) return true;
+            if (TakeFromInbox(bucket, task, bucket)) return true;
+        }
+        size_t stolen = StealFromOthers(bucket, task);
+        if (counters)
+        {
+            WorkerCounters::Add(counters->stealAttempts, 1);
+            if (stolen) WorkerCounters::Add(counters->stolen, stolen);
+            else WorkerCounters::Add(counters->stealFailures, 1);
+        }
+        return stolen > 0;
+    }
+    bool HasWork() const
+    {
+        for (const auto& b : m_buckets)
+        {
+            if (!b->local.Empty() || b->inboxSize.load(std::memory_order_acquire) > 0) return true;
         }
         return false;
     }
 
+    // inbox 满时按背压策略等待、丢弃最早的任务或返回 FULL；被丢弃的任务在释放锁之后才析构
     template<typename F>
     QueueStatus AddInternal(F&& task, const size_t bucket)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        bool ready = m_notFull.wait_for(
-            lock,
-            std::chrono::seconds(m_waitTime),
-            [this, bucket]
+        Bucket& b = *m_buckets[bucket];
+        T dropped;
+        {
+            std::unique_lock<std::mutex> lock(b.inboxMutex);
+            if (!m_needStop.load() && b.inbox.size() >= m_maxsize)
             {
-                return m_needStop.load() || !IsFull(bucket);
-            });
-
-        if (!ready) return QueueStatus::TIMEOUT;
-        if (m_needStop.load()) return QueueStatus::STOPPED;
+                if (m_backpressure.Policy() == BackpressurePolicy::DropOldest)
+                {
+                    dropped = std::move(b.inbox.front());
+                    b.inbox.pop_front();
+                    m_backpressure.RecordDropped();
+                }
+                else if (!m_backpressure.Waits())
+                {
+                    return QueueStatus::FULL;
+                }
+                else
+                {
+                    ++b.waitingProducers;
+                    bool ready = Backpressure::Wait(
+                        b.notFull, lock, m_backpressure.Deadline(),
+                        [this, &b]
+                        {
+                            return m_needStop.load() || b.inbox.size() < m_maxsize;
+                        });
+                    --b.waitingProducers;
+                    if (!ready) return QueueStatus::TIMEOUT;
+                }
+            }
+            if (m_needStop.load()) return QueueStatus::STOPPED;
 
-        m_queues[bucket].emplace_back(std::forward<F>(task));
-        m_notEmpty.notify_one();
+            b.inbox.emplace_back(std::forward<F>(task));
+            b.inboxSize.store(b.inbox.size(), std::memory_order_release);
+        }
+        UpdateHighWatermark(b.highWatermark, b.Depth());
+        m_parker.NotifyWork();
         return QueueStatus::OK;
     }
 
+    template<typename It>
+    size_t AddRangeInternal(It first, It last, const size_t bucket)
+    {
+        Bucket& b = *m_buckets[bucket];
+        size_t added = 0;
+        std::vector<T> dropped;
+        std::unique_lock<std::mutex> lock(b.inboxMutex);
+        auto deadline = m_backpressure.Deadline();
+        while (first != last)
+        {
+            if (!m_needStop.load() && b.inbox.size() >= m_maxsize)
+            {
+                if (m_backpressure.Policy() == BackpressurePolicy::DropOldest)
+                {
+                    dropped.emplace_back(std::move(b.inbox.front()));
+                    b.inbox.pop_front();
+                    m_backpressure.RecordDropped();
+                }
+                else if (!m_backpressure.Waits())
+                {
+                    break;
+                }
+                else
+                {
+                    ++b.waitingProducers;
+                    bool ready = Backpressure::Wait(
+                        b.notFull, lock, deadline,
+                        [this, &b]
+                        {
+                            return m_needStop.load() || b.inbox.size() < m_maxsize;
+                        });
+                    --b.waitingProducers;
+                    if (!ready) break;
+                }
+            }
+            if (m_needStop.load()) break;
+
+            size_t batch = 0;
+            for (; first != last && b.inbox.size() < m_maxsize; ++first, ++batch)
+            {
+                b.inbox.emplace_back(*first);
+            }
+            b.inboxSize.store(b.inbox.size(), std::memory_order_release);
+            UpdateHighWatermark(b.highWatermark, b.Depth());
+            added += batch;
+
+            lock.unlock();
+            m_parker.NotifyWork(batch); // 只唤醒与新任务数量相当的空闲线程
+            lock.lock();
+        }
+        lock.unlock();
+        return added;
+    }
+
 public:
-    SyncQueue(size_t bucketCount, size_t maxsize = 200, size_t waitTime = 1)
+    WorkStealingSyncQueue(size_t bucketCount, size_t maxsize = 200, size_t waitTime = 1)
         : m_maxsize(maxsize),
           m_bucketCount(bucketCount),
-          m_waitTime(waitTime),
-          m_needStop(false)
+          m_backpressure(BackpressurePolicy::BlockWithTimeout, std::chrono::seconds(waitTime)),
+          m_needStop(false),
+          m_stealHalf(true)
     {
-        m_queues.resize(bucketCount);
+        m_buckets.reserve(bucketCount);
+        for (size_t i = 0; i < bucketCount; ++i)
+        {
+            m_buckets.emplace_back(std::make_unique<Bucket>(maxsize));
+        }
     }
-    ~SyncQueue()
+    ~WorkStealingSyncQueue()
     {
         Stop(true);
     }
 
+    // 指定每个桶依次窃取的其他桶（例如按 CPU 拓扑由近到远），只能在工作线程开始取任务之前调用
+    void SetStealOrder(std::vector<std::vector<size_t>> order)
+    {
+        m_stealOrder = std::move(order);
+    }
+
+    // 开启或关闭批量窃取（默认开启），只能在工作线程开始取任务之前调用
+    void SetStealHalf(bool enable)
+    {
+        m_stealHalf = enable;
+    }
+
+    // 返回 OK / STOPPED，或按背压策略返回 TIMEOUT / FULL；未返回 OK 时 task 没有被移动
     QueueStatus AddTask(T&& task, const size_t bucket)
     {
         return AddInternal(std::forward<T>(task), bucket);
@@ -109,31 +318,85 @@ public:
         return AddInternal(task, bucket);
     }
 
-    QueueStatus TakeTask(T& task, size_t bucket)
+    // 一次加锁把 [first, last) 放入指定桶，返回实际放入的数量（停止或按背压策略放弃时可能少于区间长度）
+    template<typename It>
+    size_t AddTasks(It first, It last, const size_t bucket)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        bool ready = m_notEmpty.wait_for(
-            lock,
-            std::chrono::seconds(m_waitTime),
-            [this]
-            {
-                return m_needStop.load() || TotalSizeUnsafe() > 0;
-            });
+        return AddRangeInternal(first, last, bucket);
+    }
 
-        if (!ready) return QueueStatus::TIMEOUT;
-        if (m_needStop.load()) return QueueStatus::STOPPED;
+    // inbox 满时的处理方式，可在运行中修改；工作线程压入自己本地队列不受影响
+    Backpressure& GetBackpressure()
+    {
+        return m_backpressure;
+    }
+    const Backpressure& GetBackpressure() const
+    {
+        return m_backpressure;
+    }
+
+    // 仅由 bucket 对应的工作线程调用：无锁压入自己的本地队列，队列满时返回 false 且不移动 task
+    template<typename F>
+    bool PushLocal(F&& task, const size_t bucket)
+    {
+        if (m_needStop.load()) return false;
+        Bucket& b = *m_buckets[bucket];
+        if (!b.local.Push(std::forward<F>(task))) return false;
+        UpdateHighWatermark(b.highWatermark, b.Depth());
+        m_parker.NotifyWork(); // 唤醒可能在睡眠的窃取者
+        return true;
+    }
 
-        if (!PopFromOwn(bucket, task))
+    // 只在 inbox 锁无人持有时放入，锁被占用、队列已满或已停止时返回 false 且不移动 task；
+    // 外部生产者借此避开正被其他生产者或窃取者使用的桶
+    template<typename F>
+    bool TryAddUncontended(F&& task, const size_t bucket)
+    {
+        Bucket& b = *m_buckets[bucket];
+        if (b.inboxSize.load(std::memory_order_relaxed) >= m_maxsize) return false;
         {
-            if (!StealFromOthers(bucket, task))
-            {
-                // 理论上在 ready 为 true 时不应出现，但为安全起见返回 TIMEOUT
-                return QueueStatus::TIMEOUT;
-            }
+            std::unique_lock<std::mutex> lock(b.inboxMutex, std::try_to_lock);
+            if (!lock.owns_lock() || m_needStop.load() || b.inbox.size() >= m_maxsize) return false;
+            b.inbox.emplace_back(std::forward<F>(task));
+            b.inboxSize.store(b.inbox.size(), std::memory_order_release);
         }
+        UpdateHighWatermark(b.highWatermark, b.Depth());
+        m_parker.NotifyWork();
+        return true;
+    }
 
-        m_notFull.notify_one();
-        return QueueStatus::OK;
+    // 不阻塞地放入指定桶的 inbox，队列已满或已停止时返回 false 且不移动 task
+    template<typename F>
+    bool TryAddTask(F&& task, const size_t bucket)
+    {
+        Bucket& b = *m_buckets[bucket];
+        {
+            std::lock_guard<std::mutex> lock(b.inboxMutex);
+            if (m_needStop.load() || b.inbox.size() >= m_maxsize) return false;
+            b.inbox.emplace_back(std::forward<F>(task));
+            b.inboxSize.store(b.inbox.size(), std::memory_order_release);
+        }
+        UpdateHighWatermark(b.highWatermark, b.Depth());
+        m_parker.NotifyWork();
+        return true;
+    }
+
+    // 不阻塞地取出一个任务：bucket 为调用者自己的桶时依次尝试本地队列、inbox 和窃取；
+    // bucket >= 桶数量时（外部线程）只从各个桶窃取。停止后仍可取出剩余任务
+    bool TryTakeTask(T& task, size_t bucket, WorkerCounters* counters = nullptr)
+    {
+        return TryTake(task, bucket, counters);
+    }
+
+    // 不设超时：没有任务时线程一直停靠，Stop() 会唤醒所有停靠的线程
+    // counters 非空时记录该工作线程的窃取统计
+    QueueStatus TakeTask(T& task, size_t bucket, WorkerCounters* counters = nullptr)
+    {
+        if (m_needStop.load()) return QueueStatus::STOPPED;
+        return m_parker.Park(
+            [this, &task, bucket, counters]{ return TryTake(task, bucket, counters); },
+            [this]{ return HasWork(); },
+            m_needStop);
     }
 
     void Stop(bool discardPending = false)
@@ -144,30 +407,68 @@ public:
             return; // 已经停止
         }
 
+        for (auto& b : m_buckets)
         {
-            std::lock_guard<std::mutex> locker(m_mutex);
-            if (discardPending)
             {
-                for (auto& q : m_queues) q.clear();
+                std::lock_guard<std::mutex> locker(b->inboxMutex);
+                if (discardPending)
+                {
+                    b->inbox.clear();
+                    b->inboxSize.store(0, std::memory_order_release);
+                }
             }
+            b->notFull.notify_all();
         }
-        m_notFull.notify_all();
-        m_notEmpty.notify_all();
+        if (discardPending)
+        {
+            // Steal 可由任意线程调用，借此清空本地队列
+            T task;
+            for (auto& b : m_buckets)
+            {
+                while (!b->local.Empty())
+                {
+                    b->local.Steal(task);
+                }
+            }
+        }
+        m_parker.NotifyAll();
     }
 
     bool Full(const size_t index) const
     {
-        std::lock_guard<std::mutex> locker(m_mutex);
-        return IsFull(index);
+        std::lock_guard<std::mutex> locker(m_buckets[index]->inboxMutex);
+        return m_buckets[index]->inbox.size() >= m_maxsize;
     }
     bool Empty(const size_t index) const
     {
-        std::lock_guard<std::mutex> locker(m_mutex);
-        return IsEmpty(index);
+        return m_buckets[index]->local.Empty()
+            && m_buckets[index]->inboxSize.load(std::memory_order_acquire) == 0;
+    }
+    // 正在自旋 / 已睡眠的空闲线程数量
+    uint32_t Spinning() const
+    {
+        return m_parker.Spinning();
+    }
+    uint32_t Sleeping() const
+    {
+        return m_parker.Sleeping();
+    }
+    // 指定桶当前长度与历史最大长度
+    size_t Size(const size_t index) const
+    {
+        return m_buckets[index]->Depth();
+    }
+    size_t HighWatermark(const size_t index) const
+    {
+        return m_buckets[index]->highWatermark.load(std::memory_order_relaxed);
     }
     size_t Size() const
     {
-        std::lock_guard<std::mutex> locker(m_mutex);
-        return TotalSizeUnsafe();
+        size_t size = 0;
+        for (const auto& b : m_buckets)
+        {
+            size += b->local.Size() + b->inboxSize.load(std::memory_order_acquire);
+        }
+        return size;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "SyncQueueCommon.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// 单个工作线程的运行计数，独占缓存行，避免不同线程的计数互相伪共享
+// 每组计数只由对应的工作线程写入（单写者），因此用 load + store 代替原子读改写，
+// 其他线程随时可以无锁读取，得到的是近似但不会撕裂的快照
+struct alignas(CacheLineSize) WorkerCounters
+{
+    std::atomic<uint64_t> executed{0};      // 执行的任务数
+    std::atomic<uint64_t> stolen{0};        // 从其他桶窃取到的任务数
+    std::atomic<uint64_t> stealAttempts{0}; // 窃取尝试次数（每次扫描其他桶算一次）
+    std::atomic<uint64_t> stealFailures{0}; // 扫描一遍仍未窃取到任务的次数
+    std::atomic<uint64_t> idleNs{0};        // 等待任务的时间
+    std::atomic<uint64_t> busyNs{0};        // 执行任务的时间
+
+    static void Add(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+    // 单调时钟的纳秒读数，用于累计 idleNs / busyNs
+    static uint64_t NowNs()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+};
+
+// 记录队列长度的历史最大值，可由多个生产者并发更新
+inline void UpdateHighWatermark(std::atomic<size_t>& watermark, size_t size)
+{
+    size_t current = watermark.load(std::memory_order_relaxed);
+    while (size > current
+           && !watermark.compare_exchange_weak(current, size, std::memory_order_relaxed))
+    {
+    }
+}
@@ -1,50 +1,183 @@
 #pragma once
 
 #include "./SyncQueue/CacheSyncQueue.hpp"
+#include "./SyncQueue/IdleTracker.hpp"
+#include "Cancellation.h"
+#include "Future.h"
+#include "InplaceTask.h"
+#include "ScheduleAwaiter.h"
+#include "ThreadPoolStats.h"
+#include "TimerWheel.h"
+#include <algorithm>
 #include <atomic>
-#include <functional>
+#include <chrono>
 #include <future>
+#include <iterator>
+#include <memory>
 #include <thread>
-#include <unordered_map>
+#include <vector>
 
 inline constexpr size_t CacheMaxTaskSize = 1000;
 inline constexpr size_t KeepAliveTime = 10;
+// 默认扩容策略：没有空闲线程且排队任务达到 GrowBacklog 个，或队列非空但 GrowQueueDelay 内没有线程取走任务时扩容，
+// 两次新建线程至少间隔 GrowSpawnInterval
+inline constexpr size_t GrowBacklog = 16;
+inline constexpr std::chrono::milliseconds GrowQueueDelay{20};
+inline constexpr std::chrono::milliseconds GrowSpawnInterval{1};
+// 默认保留的待命线程数：空闲超时退役的线程先停靠待命，扩容时一次唤醒即可重新激活
+inline constexpr int DefaultStandbyThreads = 2;
 class CacheThreadPool
 { 
 public:
-    using Task = std::function<void()>;
+    using Task = InplaceTask<TaskInlineSize>;
 private:
-    std::unordered_map<std::thread::id,std::thread> m_threadgroup;
+    // 工作线程按槽位固定存放，线程退役、待命与重新激活只修改槽位状态，不查找线程表
+    // 状态只在持有 m_mutex 时修改，待命线程只读取自己槽位的状态
+    enum class WorkerState : uint8_t
+    {
+        Free,    // 没有线程，或线程已退出、等待下次占用时 join
+        Active,  // 正在从队列取任务
+        Standby  // 已退役，停靠在 wake 上等待重新激活
+    };
+    struct alignas(CacheLineSize) WorkerSlot
+    {
+        std::thread thread;
+        std::atomic<WorkerState> state{WorkerState::Free};
+        EventCount wake;
+    };
 
     int m_coreThreadnum;
     int m_maxThreadnum;
 
     std::atomic<int> m_idelThreadnum;
-    std::atomic<int> m_currentThreadnum;
+    std::atomic<int> m_currentThreadnum;   // 活动线程数，不含待命线程
+    std::atomic<int> m_standbyThreadnum;
+    std::atomic<int> m_maxStandby;
     std::atomic<bool> m_running;
+    std::atomic<uint64_t> m_cancelledTasks{0}; // 带 TaskGuard 的任务出队后被丢弃的数量
     std::once_flag m_flag;
 
     mutable std::mutex m_mutex;
 
-    SyncQueue<Task> m_taskqueue;
+    CacheSyncQueue<Task> m_taskqueue;
+
+    // 线程数会伸缩，线程与计数都按槽位保存，槽位内的计数在线程更替时累计保留
+    size_t m_slotCount;
+    std::unique_ptr<WorkerSlot[]> m_workers;
+    std::unique_ptr<WorkerCounters[]> m_counters;
+
+    // 扩容策略参数与状态，时间均为 WorkerCounters::NowNs() 的纳秒读数
+    std::atomic<size_t> m_growBacklog;
+    std::atomic<uint64_t> m_growDelayNs;
+    std::atomic<uint64_t> m_spawnIntervalNs;
+    std::atomic<uint64_t> m_lastTakeNs;  // 最近一次有工作线程从队列取到任务的时间
+    std::atomic<uint64_t> m_lastSpawnNs; // 最近一次扩容的时间
+
+    IdleTracker m_idle; // 已接受与已结束的任务数，供 WaitIdle 判断静止
+    TimerWheel m_timer; // 到期的延迟任务通过 TryAddTask 进入队列
 
     void Start(int threadnum);
-    void RunInThread();
+    bool ActivateWorker();
+    void MaybeGrow();
+    bool Retire(size_t slot);
+    void RunInThread(size_t slot);
     void Stop();
+    // 到期任务只做非阻塞提交，队列满时返回 false 由时间轮下一个 tick 重试，定时线程上不执行用户任务；
+    // 线程池已停止时丢弃
+    bool DispatchTimerTask(Task& task)
+    {
+        return TryAddTask(std::move(task)) || !m_running.load();
+    }
 public:
-    CacheThreadPool(int coreThreadnum = 8,int maxThreadnum = std::thread::hardware_concurrency()*2)
+    CacheThreadPool(int coreThreadnum = 8,int maxThreadnum = std::thread::hardware_concurrency()*2,
+                    QueueBackend backend = QueueBackend::List)
     :m_coreThreadnum(coreThreadnum),m_maxThreadnum(maxThreadnum),
-     m_idelThreadnum(0),m_currentThreadnum(0),
-     m_taskqueue(CacheMaxTaskSize,KeepAliveTime),m_running(false)
+     m_idelThreadnum(0),m_currentThreadnum(0),m_standbyThreadnum(0),m_maxStandby(DefaultStandbyThreads),
+     m_taskqueue(CacheMaxTaskSize,KeepAliveTime,backend),m_running(false),
+     m_slotCount(static_cast<size_t>(std::max(std::max(coreThreadnum,maxThreadnum),1))),
+     m_workers(std::make_unique<WorkerSlot[]>(m_slotCount)),
+     m_counters(std::make_unique<WorkerCounters[]>(m_slotCount)),
+     m_growBacklog(GrowBacklog),
+     m_growDelayNs(std::chrono::duration_cast<std::chrono::nanoseconds>(GrowQueueDelay).count()),
+     m_spawnIntervalNs(std::chrono::duration_cast<std::chrono::nanoseconds>(GrowSpawnInterval).count()),
+     m_lastTakeNs(WorkerCounters::NowNs()),
+     m_lastSpawnNs(0),
+     m_timer([this](Task& task){ return DispatchTimerTask(task); })
     {
+        m_idle.SetDiscardCounter(&m_taskqueue.GetBackpressure().DroppedCounter());
+        m_taskqueue.SetConsumerCount(m_slotCount);
         Start(coreThreadnum);
     }
     ~CacheThreadPool(){Stop();}
     void StopThreadPool(){Stop();}
-    void AddTask(Task&& task);
-    void AddTask(const Task& task);
+
+    // 不停止工作线程的统计快照，workers 按线程槽位排列
+    ThreadPoolStats GetStats() const;
+    // 提交任务并返回结果：队列满时按背压策略等待、拒绝、在当前线程执行或丢弃最早的任务
+    // 返回 Rejected / TimedOut / Stopped 时任务没有执行
+    SubmitStatus AddTask(Task&& task);
+
+    // 不阻塞地提交任务，队列已满（不论背压策略）或线程池已停止时返回 false 且不移动 task
+    bool TryAddTask(Task&& task);
+    // 当前线程是否为本线程池的工作线程
+    bool InWorkerThread() const;
+
+    // 在调用线程上执行一个排队中的任务，没有可执行的任务时返回 false
+    // 工作线程等待子任务时借此参与计算而不是占着线程阻塞（见 TaskGroup.h）
+    bool RunPendingTask();
+
+    // 线程池是否仍在运行
+    bool IsRunning() const { return m_running.load(); }
+
+    // 阻塞直到所有已接受的任务（排队中与执行中，包括它们派生的子任务）都已结束，或线程池已停止
+    // 尚未到期的定时任务不计在内；不能在本线程池的工作线程内调用
+    void WaitIdle()
+    {
+        m_idle.WaitIdle(std::chrono::steady_clock::time_point::max());
+    }
+    // 与 WaitIdle 相同，timeout 内仍未静止时返回 false
+    template<typename Rep,typename Period>
+    bool WaitIdleFor(const std::chrono::duration<Rep,Period>& timeout)
+    {
+        return m_idle.WaitIdle(std::chrono::steady_clock::now()
+                               + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout));
+    }
+
+    // co_await pool.Schedule() 把协程切换到本线程池的工作线程上继续执行（C++20 协程，见 CoTask.h）
+    ScheduleAwaiter<CacheThreadPool> Schedule() { return ScheduleAwaiter<CacheThreadPool>(*this); }
+
+    // 延迟与周期任务：由一个定时线程在到期时放入任务队列，等待期间不占用工作线程
+    // 返回的句柄可传给 CancelTimer，线程池停止后返回 InvalidTimerId
+    TimerId ScheduleAfter(TimerWheel::Clock::duration delay, Task task)
+    {
+        return m_timer.ScheduleAfter(delay, std::move(task));
+    }
+    TimerId ScheduleAt(TimerWheel::Clock::time_point when, Task task)
+    {
+        return m_timer.ScheduleAt(when, std::move(task));
+    }
+    // 每隔 period 执行一次，上一次还未执行完时跳过本次
+    TimerId ScheduleEvery(TimerWheel::Clock::duration period, Task task)
+    {
+        return m_timer.ScheduleEvery(period, std::move(task));
+    }
+    // 取消尚未到期的定时器，成功时返回 true
+    bool CancelTimer(TimerId id)
+    {
+        return m_timer.Cancel(id);
+    }
+
+    // 按优先级提交：High 先于 Normal 先于 Low 被取出，每个优先级的通道有独立的容量
+    SubmitStatus AddTask(TaskPriority priority, Task&& task);
+
     template<typename T,typename... Args>
     auto AddTaskWithReturn(T&& task,Args&&... args)->std::future<decltype(task(args...))>
+    {
+        return AddTaskWithReturn(TaskPriority::Normal, std::forward<T>(task), std::forward<Args>(args)...);
+    }
+
+    template<typename T,typename... Args>
+    auto AddTaskWithReturn(TaskPriority priority,T&& task,Args&&... args)->std::future<decltype(task(args...))>
     {
         using ReturnType = decltype(task(args...));
         
@@ -54,22 +187,122 @@ public:
             return std::future<ReturnType>();
         }
         
-        // 使用 packaged_task 包装任务，可以获取返回值
-        auto packaged_task = std::make_shared<std::packaged_task<ReturnType()>>(
-            std::bind(std::forward<T>(task), std::forward<Args>(args)...)
-        );
-        
-        // 获取 future 用于后续获取返回值
-        std::future<ReturnType> result = packaged_task->get_future();
+        // promise、可调用对象和参数内联在同一个 Task 中，执行时结果写入 future
+        auto packaged = PackageTask<Task>(std::forward<T>(task), std::forward<Args>(args)...);
         
-        // 将 packaged_task 包装成 void() 类型的 Task，以便放入队列
-        Task wrapper_task = [packaged_task]() {
-            (*packaged_task)();  // 执行任务，结果会自动设置到 future 中
-        };
-        
-        // 将任务加入队列
-        m_taskqueue.AddTask(std::move(wrapper_task));
+        // 将任务加入对应优先级的通道，被背压策略拒绝时同样返回无效的 future
+        if(!Accepted(AddTask(priority, std::move(packaged.first))))
+        {
+            return std::future<ReturnType>();
+        }
         
-        return result;
+        return std::move(packaged.second);
+    }
+
+    // 带取消令牌或截止时间提交：任务出队后、执行前检查 guard，已取消或已过期时不执行，计入 cancelledTasks
+    // 同一个 CancellationSource 的令牌可以分给一整批任务，Cancel() 一次使整批在出队时被丢弃
+    template<typename F>
+    SubmitStatus AddTask(TaskGuard guard,F&& func)
+    {
+        return AddTask(MakeGuardedTask<Task>(std::move(guard), &m_cancelledTasks, std::forward<F>(func)));
+    }
+
+    // 被丢弃的任务不执行，future 得到 TaskCancelled 异常；线程池未运行或被背压策略拒绝时返回无效的 future
+    template<typename T,typename... Args>
+    auto AddTaskWithReturn(TaskGuard guard,T&& task,Args&&... args)->std::future<decltype(task(args...))>
+    {
+        using ReturnType = decltype(task(args...));
+
+        if(!m_running.load())
+        {
+            return std::future<ReturnType>();
+        }
+
+        auto packaged = PackageGuardedTask<Task>(std::move(guard), &m_cancelledTasks,
+                                                 std::forward<T>(task), std::forward<Args>(args)...);
+        if(!Accepted(AddTask(std::move(packaged.first))))
+        {
+            return std::future<ReturnType>();
+        }
+        return std::move(packaged.second);
+    }
+
+    // 与 AddTaskWithReturn 相同，但返回可挂接后续任务的 Future：Then 的后续任务默认在本线程池上执行，
+    // 等待结果的一方不必阻塞工作线程。线程池已停止或任务被背压策略拒绝时返回的 Future 带 broken_promise 异常
+    template<typename T,typename... Args>
+    auto AddTaskWithFuture(T&& task,Args&&... args)
+    {
+        auto packaged = PackageFutureTask<Task>(Executor(*this), std::forward<T>(task), std::forward<Args>(args)...);
+        AddTask(std::move(packaged.first));
+        return std::move(packaged.second);
+    }
+
+    // 扩容策略：没有空闲线程且排队任务数达到 backlog，或队列非空但已有 maxQueueDelay 没有线程取走任务
+    // （所有线程都被长任务占住）时新建工作线程，直到 maxThreadnum。提交任务和取到任务时都会检查；
+    // 两次新建之间至少间隔 spawnInterval。超出核心线程数的线程仍在空闲 KeepAliveTime 秒后回收
+    void SetGrowthPolicy(size_t backlog, std::chrono::milliseconds maxQueueDelay, std::chrono::milliseconds spawnInterval)
+    {
+        m_growBacklog.store(backlog);
+        m_growDelayNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(maxQueueDelay).count());
+        m_spawnIntervalNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(spawnInterval).count());
+    }
+
+    // 保留的待命线程数上限：超出核心线程数的线程空闲 KeepAliveTime 秒后退役，待命线程未满时停靠待命，
+    // 扩容时优先唤醒待命线程，只有待命线程已满才真正退出。调小时多出的待命线程立即退出
+    void SetStandbyThreads(int count);
+
+    // 通道满时的处理方式；timeout 只对 BlockWithTimeout 有效。批量提交遇到 CallerRuns 时按 Reject 处理，
+    // 返回值为实际放入的数量
+    void SetBackpressure(BackpressurePolicy policy, std::chrono::milliseconds timeout = std::chrono::seconds(1))
+    {
+        m_taskqueue.GetBackpressure().Set(policy, timeout);
+    }
+
+    // 低优先级通道被连续跳过 threshold 次后优先服务一次，避免饿死；0 表示严格按优先级
+    void SetPriorityAging(uint32_t threshold)
+    {
+        m_taskqueue.SetAgingThreshold(threshold);
+    }
+
+    // 批量提交 [first, last) 中的可调用对象：一次获取队列、只唤醒与任务数相当的空闲线程
+    // 返回实际提交的任务数
+    template<typename ForwardIt>
+    size_t AddTasks(ForwardIt first, ForwardIt last, TaskPriority priority = TaskPriority::Normal)
+    {
+        static_assert(IsForwardIterator<ForwardIt>, "AddTasks requires forward iterators; use AddTasksWithReturn for single-pass ranges");
+        if(!m_running.load()) return 0;
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        m_idle.Submitted(count);
+        size_t added = m_taskqueue.AddTasks(first, last, priority);
+        if(added < count) m_idle.Completed(count - added);
+        MaybeGrow();
+        return added;
+    }
+
+    // 批量提交带返回值的任务，返回与输入顺序一致的 future 列表；区间只遍历一次，可以是单遍输入迭代器
+    template<typename InputIt>
+    auto AddTasksWithReturn(InputIt first, InputIt last, TaskPriority priority = TaskPriority::Normal)
+    {
+        using Func = typename std::iterator_traits<InputIt>::value_type;
+        using ReturnType = std::invoke_result_t<Func&>;
+
+        std::vector<std::future<ReturnType>> results;
+        if(!m_running.load()) return results;
+
+        std::vector<Task> tasks;
+        // 单遍输入迭代器不能先计数，边遍历边放入
+        if constexpr (IsForwardIterator<InputIt>)
+        {
+            tasks.reserve(std::distance(first, last));
+            results.reserve(tasks.capacity());
+        }
+        for(; first != last; ++first)
+        {
+            auto packaged = PackageTask<Task>(*first);
+            tasks.emplace_back(std::move(packaged.first));
+            results.emplace_back(std::move(packaged.second));
+        }
+        AddTasks(std::make_move_iterator(tasks.begin()), std::make_move_iterator(tasks.end()), priority);
+        return results;
     }
 };
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "InplaceTask.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// 任务被丢弃的原因
+enum class CancelReason
+{
+    None = 0,
+    Cancelled = 1,      // 取消令牌已触发
+    DeadlineExpired = 2 // 出队时已超过截止时间
+};
+
+// 带取消令牌或截止时间的任务在执行前被丢弃时，future 得到的异常
+class TaskCancelled : public std::runtime_error
+{
+private:
+    CancelReason m_reason;
+
+public:
+    explicit TaskCancelled(CancelReason reason)
+        : std::runtime_error(reason == CancelReason::DeadlineExpired ? "task deadline expired" : "task cancelled"),
+          m_reason(reason)
+    {}
+
+    CancelReason Reason() const { return m_reason; }
+};
+
+namespace detail
+{
+// 令牌的共享状态，侵入式引用计数，一次取消对所有持有同一令牌的任务生效
+struct CancellationState
+{
+    std::atomic<uint32_t> refs{1};
+    std::atomic<bool> cancelled{false};
+
+    void AddRef() { refs.fetch_add(1, std::memory_order_relaxed); }
+    void Release()
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+};
+}
+
+// 只读的取消令牌，只有一个指针大小，可随任务复制；默认构造的令牌永远不会被取消
+class CancellationToken
+{
+private:
+    detail::CancellationState* m_state = nullptr;
+
+    friend class CancellationSource;
+    explicit CancellationToken(detail::CancellationState* state) : m_state(state)
+    {
+        if (m_state) m_state->AddRef();
+    }
+
+public:
+    CancellationToken() = default;
+    CancellationToken(const CancellationToken& other) : CancellationToken(other.m_state) {}
+    CancellationToken(CancellationToken&& other) noexcept : m_state(std::exchange(other.m_state, nullptr)) {}
+    CancellationToken& operator=(CancellationToken other) noexcept
+    {
+        std::swap(m_state, other.m_state);
+        return *this;
+    }
+    ~CancellationToken()
+    {
+        if (m_state) m_state->Release();
+    }
+
+    bool IsCancelled() const
+    {
+        return m_state && m_state->cancelled.load(std::memory_order_acquire);
+    }
+    bool CanBeCancelled() const { return m_state != nullptr; }
+};
+
+// 取消的发起方：Cancel() 只写一个原子标志，与已经提交了多少任务无关，
+// 持有其令牌的任务在出队执行前看到标志后被丢弃，不需要遍历队列
+class CancellationSource
+{
+private:
+    detail::CancellationState* m_state;
+
+public:
+    CancellationSource() : m_state(new detail::CancellationState()) {}
+    CancellationSource(const CancellationSource&) = delete;
+    CancellationSource& operator=(const CancellationSource&) = delete;
+    ~CancellationSource() { m_state->Release(); }
+
+    CancellationToken Token() const { return CancellationToken(m_state); }
+    void Cancel() { m_state->cancelled.store(true, std::memory_order_release); }
+    bool IsCancelled() const { return m_state->cancelled.load(std::memory_order_acquire); }
+};
+
+// 提交时附带的取消条件：取消令牌与可选的截止时间，任意一个满足时任务在出队后被丢弃
+struct TaskGuard
+{
+    using Clock = std::chrono::steady_clock;
+
+    CancellationToken token;
+    Clock::time_point deadline = Clock::time_point::max(); // max 表示没有截止时间
+
+    TaskGuard() = default;
+    explicit TaskGuard(CancellationToken cancelToken, Clock::time_point until = Clock::time_point::max())
+        : token(std::move(cancelToken)), deadline(until)
+    {}
+    explicit TaskGuard(Clock::time_point until) : deadline(until) {}
+
+    // 从现在起 timeout 之后过期
+    static TaskGuard Within(Clock::duration timeout, CancellationToken cancelToken = CancellationToken())
+    {
+        return TaskGuard(std::move(cancelToken), Clock::now() + timeout);
+    }
+
+    // 只有设置了截止时间才读取时钟
+    CancelReason Check() const
+    {
+        if (token.IsCancelled()) return CancelReason::Cancelled;
+        if (deadline != Clock::time_point::max() && Clock::now() >= deadline) return CancelReason::DeadlineExpired;
+        return CancelReason::None;
+    }
+};
+
+namespace detail
+{
+template<typename F, typename = void>
+struct HasAbandon : std::false_type {};
+template<typename F>
+struct HasAbandon<F, std::void_t<decltype(std::declval<F&>().Abandon(std::exception_ptr()))>> : std::true_type {};
+}
+
+// 执行前检查 TaskGuard 的包装：条件满足时不调用 func，计入 cancelled（可为空）；
+// func 带有结果（PromiseTask）时改为以 TaskCancelled 完成它的 future
+template<typename F>
+class GuardedTask
+{
+private:
+    TaskGuard m_guard;
+    std::atomic<uint64_t>* m_cancelled;
+    F m_func;
+
+public:
+    template<typename Fn>
+    GuardedTask(TaskGuard guard, std::atomic<uint64_t>* cancelled, Fn&& func)
+        : m_guard(std::move(guard)), m_cancelled(cancelled), m_func(std::forward<Fn>(func))
+    {}
+
+    void operator()()
+    {
+        CancelReason reason = m_guard.Check();
+        if (reason == CancelReason::None)
+        {
+            m_func();
+            return;
+        }
+        if (m_cancelled) m_cancelled->fetch_add(1, std::memory_order_relaxed);
+        if constexpr (detail::HasAbandon<F>::value)
+        {
+            m_func.Abandon(std::make_exception_ptr(TaskCancelled(reason)));
+        }
+    }
+};
+
+template<typename TaskType, typename F>
+TaskType MakeGuardedTask(TaskGuard guard, std::atomic<uint64_t>* cancelled, F&& func)
+{
+    return TaskType(GuardedTask<std::decay_t<F>>(std::move(guard), cancelled, std::forward<F>(func)));
+}
+
+// 与 PackageTask 相同，但任务被丢弃时 future 得到 TaskCancelled 异常而不是 broken_promise
+template<typename TaskType, typename F, typename... Args>
+auto PackageGuardedTask(TaskGuard guard, std::atomic<uint64_t>* cancelled, F&& func, Args&&... args)
+{
+    using ReturnType = std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>;
+    using Wrapper = PromiseTask<ReturnType, std::decay_t<F>, std::decay_t<Args>...>;
+
+    std::promise<ReturnType> promise(std::allocator_arg, ArenaAllocator<char>());
+    std::future<ReturnType> result = promise.get_future();
+    TaskType task = MakeGuardedTask<TaskType>(
+        std::move(guard), cancelled,
+        Wrapper(std::move(promise), std::forward<F>(func), std::forward<Args>(args)...));
+    return std::make_pair(std::move(task), std::move(result));
+}
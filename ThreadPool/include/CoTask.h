@@ -0,0 +1,225 @@
+#pragma once
+
+// 可选的 C++20 协程层：惰性协程任务 CoTask<T>、阻塞等待 SyncWait、在线程池上分离运行的 Spawn，
+// 以及基于线程池时间轮的 ResumeAfter。线程池本身仍按 C++17 编译，只有包含本头文件的代码需要 C++20
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "CoTask.h requires C++20 coroutine support (-std=c++20)"
+#endif
+
+#include "ScheduleAwaiter.h"
+#include "TimerWheel.h"
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <utility>
+#include <variant>
+
+template<typename T = void>
+class CoTask;
+
+namespace detail
+{
+// 协程结束时对称转移到等待者，等待者在完成该协程的工作线程上直接继续执行，不重新入队
+struct FinalAwaiter
+{
+    bool await_ready() const noexcept { return false; }
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+    {
+        auto continuation = handle.promise().m_continuation;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+};
+
+struct PromiseBase
+{
+    std::coroutine_handle<> m_continuation;
+
+    std::suspend_always initial_suspend() const noexcept { return {}; } // 惰性：被 co_await 时才开始执行
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+};
+
+template<typename T>
+struct CoTaskPromise : PromiseBase
+{
+    std::variant<std::monostate, T, std::exception_ptr> m_result;
+
+    CoTask<T> get_return_object() noexcept;
+    template<typename U>
+    void return_value(U&& value)
+    {
+        m_result.template emplace<1>(std::forward<U>(value));
+    }
+    void unhandled_exception() noexcept
+    {
+        m_result.template emplace<2>(std::current_exception());
+    }
+    T Result()
+    {
+        if (m_result.index() == 2) std::rethrow_exception(std::get<2>(m_result));
+        return std::move(std::get<1>(m_result));
+    }
+};
+
+template<>
+struct CoTaskPromise<void> : PromiseBase
+{
+    std::exception_ptr m_exception;
+
+    CoTask<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void unhandled_exception() noexcept
+    {
+        m_exception = std::current_exception();
+    }
+    void Result()
+    {
+        if (m_exception) std::rethrow_exception(m_exception);
+    }
+};
+
+// 立即开始、结束时自行销毁的协程，用于 SyncWait 与 Spawn 的驱动
+struct DetachedCoroutine
+{
+    struct promise_type
+    {
+        DetachedCoroutine get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+}
+
+// 惰性协程任务：创建时不执行，被 co_await 时在等待者所在线程开始执行，
+// 完成后在最后执行它的线程上恢复等待者。中途 co_await pool.Schedule() 即可切换到线程池
+template<typename T>
+class CoTask
+{
+public:
+    using promise_type = detail::CoTaskPromise<T>;
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+
+public:
+    explicit CoTask(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+    CoTask(CoTask&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    CoTask& operator=(CoTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+    ~CoTask()
+    {
+        if (m_handle) m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+    {
+        m_handle.promise().m_continuation = continuation;
+        return m_handle;
+    }
+    T await_resume()
+    {
+        return m_handle.promise().Result();
+    }
+};
+
+namespace detail
+{
+template<typename T>
+CoTask<T> CoTaskPromise<T>::get_return_object() noexcept
+{
+    return CoTask<T>(std::coroutine_handle<CoTaskPromise<T>>::from_promise(*this));
+}
+
+inline CoTask<void> CoTaskPromise<void>::get_return_object() noexcept
+{
+    return CoTask<void>(std::coroutine_handle<CoTaskPromise<void>>::from_promise(*this));
+}
+
+// promise 移入协程帧而不是引用调用方的局部变量，future.get() 返回后调用方立即退出也不会与 set_value 竞争
+template<typename T>
+DetachedCoroutine RunAndSignal(CoTask<T> task, std::promise<T> promise)
+{
+    try
+    {
+        if constexpr (std::is_void_v<T>)
+        {
+            co_await task;
+            promise.set_value();
+        }
+        else
+        {
+            promise.set_value(co_await task);
+        }
+    }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+    }
+}
+
+template<typename Pool>
+DetachedCoroutine RunDetached(Pool& pool, CoTask<void> task)
+{
+    co_await pool.Schedule();
+    co_await task;
+}
+}
+
+// 在调用线程上开始执行 task 并阻塞直到完成，返回结果或重新抛出异常；用于在普通函数中等待协程
+template<typename T>
+T SyncWait(CoTask<T> task)
+{
+    std::promise<T> promise;
+    auto future = promise.get_future();
+    detail::RunAndSignal(std::move(task), std::move(promise));
+    return future.get();
+}
+
+// 在线程池上分离运行 task，不等待其完成；task 抛出的异常会终止程序
+template<typename Pool>
+void Spawn(Pool& pool, CoTask<void> task)
+{
+    detail::RunDetached(pool, std::move(task));
+}
+
+// co_await ResumeAfter(pool, delay)：挂起协程，delay 之后由线程池的时间轮放回工作线程继续执行，
+// 等待期间不占用任何线程
+template<typename Pool>
+class ResumeAfterAwaiter
+{
+private:
+    Pool& m_pool;
+    std::chrono::steady_clock::duration m_delay;
+
+public:
+    ResumeAfterAwaiter(Pool& pool, std::chrono::steady_clock::duration delay) : m_pool(pool), m_delay(delay) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        // 线程池已停止时定时器不再接受任务，协程在当前线程继续执行
+        return m_pool.ScheduleAfter(m_delay, [handle]{ handle.resume(); }) != InvalidTimerId;
+    }
+    void await_resume() const noexcept {}
+};
+
+template<typename Pool>
+ResumeAfterAwaiter<Pool> ResumeAfter(Pool& pool, std::chrono::steady_clock::duration delay)
+{
+    return ResumeAfterAwaiter<Pool>(pool, delay);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 工作线程的放置方式
+enum class WorkerPlacement
+{
+    None = 0,   // 不绑定 CPU，由操作系统调度
+    Compact = 1 // 按拓扑紧凑绑定：先占满一个 NUMA 节点内同一末级缓存的物理核，再用超线程，最后跨节点
+};
+
+// 单个逻辑 CPU 的拓扑位置
+struct CpuInfo
+{
+    int cpu = 0;
+    int core = 0;    // 物理核编号（同一物理核上的超线程相同）
+    int smt = 0;     // 在所属物理核内的超线程序号
+    int llc = 0;     // 末级缓存编号，取共享该缓存的最小 CPU 号
+    int node = 0;    // NUMA 节点
+    int package = 0; // 物理插槽
+};
+
+// 从 Linux sysfs 读取的 CPU 拓扑，读取失败或非 Linux 平台时退化为单节点、单缓存的平坦拓扑
+class CpuTopology
+{
+private:
+    std::vector<CpuInfo> m_cpus; // 按 CPU 号排序
+
+    const CpuInfo* Find(int cpu) const;
+
+public:
+    static CpuTopology Detect();
+    // 解析 "0-3,8,10-11" 形式的 CPU 列表
+    static std::vector<int> ParseCpuList(const std::string& text);
+
+    const std::vector<CpuInfo>& Cpus() const { return m_cpus; }
+
+    // Compact 放置下第 i 个工作线程应绑定的 CPU 顺序，工作线程多于 CPU 时循环使用
+    std::vector<int> PlacementOrder() const;
+
+    // 两个 CPU 之间的距离：0 同一物理核，1 共享末级缓存，2 同一 NUMA 节点，3 跨节点
+    int Distance(int cpuA, int cpuB) const;
+};
+
+// 把调用线程绑定到指定 CPU，平台不支持或失败时返回 false
+bool PinCurrentThread(int cpu);
+
+// 为 count 个工作线程生成窃取顺序：victims[i] 为工作线程 i 依次尝试窃取的其他线程，
+// 按所在 CPU 的距离由近到远排列，同等距离内从 i 的下一个开始轮转，避免所有线程先挤向同一个受害者
+std::vector<std::vector<size_t>> BuildStealOrder(const CpuTopology& topology, const std::vector<int>& workerCpus);
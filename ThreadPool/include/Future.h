@@ -0,0 +1,404 @@
+#pragma once
+
+#include "./SyncQueue/EventCount.hpp"
+#include "InplaceTask.h"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+template<typename T>
+class Future;
+template<typename T>
+class Promise;
+
+// 同一线程上连续内联执行的后续任务层数上限，超过后改为提交到线程池，避免长链递归耗尽栈
+inline constexpr unsigned MaxInlineContinuationDepth = 16;
+
+// 执行后续任务的线程池的类型擦除引用，只保存一个指针和两个函数指针
+// 空执行器在完成结果的线程上直接执行后续任务
+class Executor
+{
+public:
+    using Task = InplaceTask<TaskInlineSize>;
+
+private:
+    void* m_pool = nullptr;
+    void (*m_submit)(void* pool, Task&& task) = nullptr;
+    bool (*m_inWorker)(const void* pool) = nullptr;
+
+    template<typename Pool>
+    static void Submit(void* pool, Task&& task)
+    {
+        static_cast<Pool*>(pool)->AddTask(std::move(task));
+    }
+    template<typename Pool>
+    static bool InWorker(const void* pool)
+    {
+        return static_cast<const Pool*>(pool)->InWorkerThread();
+    }
+
+public:
+    Executor() = default;
+    template<typename Pool, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Pool>, Executor>>>
+    Executor(Pool& pool) : m_pool(&pool), m_submit(&Submit<Pool>), m_inWorker(&InWorker<Pool>) {}
+
+    // 已在该线程池的工作线程上时直接执行（限制嵌套层数），否则提交到线程池
+    // 工作线程向自己的有界队列提交在队列满时会阻塞，内联执行同时省去一次入队
+    void Execute(Task&& task) const
+    {
+        static thread_local unsigned depth = 0;
+        if (!m_pool || (depth < MaxInlineContinuationDepth && m_inWorker(m_pool)))
+        {
+            ++depth;
+            task();
+            --depth;
+            return;
+        }
+        m_submit(m_pool, std::move(task));
+    }
+};
+
+namespace detail
+{
+struct Unit {};
+
+// Future 与 Promise 共享的状态：一次分配，侵入式引用计数，结果与唯一的后续任务之间用一个原子阶段交接
+// 设置结果与挂接后续任务谁后到达，谁负责执行后续任务，双方都不需要加锁
+template<typename T>
+class FutureState
+{
+public:
+    using Task = InplaceTask<TaskInlineSize>;
+    using Value = std::conditional_t<std::is_void_v<T>, Unit, T>;
+
+private:
+    enum Phase : uint8_t
+    {
+        Pending = 0,
+        HasResult = 1,
+        HasContinuation = 2,
+        Done = 3
+    };
+
+    std::atomic<uint32_t> m_refs{0};
+    std::atomic<uint8_t> m_phase{Pending};
+    std::variant<std::monostate, Value, std::exception_ptr> m_result;
+    Executor m_executor;     // 产生该结果的线程池，Then 未指定线程池时在这里执行后续任务
+    Executor m_continuationExecutor;
+    Task m_continuation;
+    EventCount m_ready;      // 只有 Wait/Get 阻塞等待时才会用到
+
+    void RunContinuation()
+    {
+        // 后续任务持有本状态的引用，移出后状态不再反向持有它，引用环就此断开
+        Task task = std::move(m_continuation);
+        m_continuationExecutor.Execute(std::move(task));
+    }
+
+    void Publish()
+    {
+        uint8_t expected = Pending;
+        if (m_phase.compare_exchange_strong(expected, HasResult, std::memory_order_acq_rel))
+        {
+            m_ready.NotifyAll();
+            return;
+        }
+        m_phase.store(Done, std::memory_order_release);
+        RunContinuation();
+    }
+
+public:
+    explicit FutureState(Executor executor) : m_executor(executor) {}
+
+    // 共享状态从 TaskArena 分配，通常由提交线程分配、在工作线程上释放
+    static void* operator new(size_t size) { return TaskArena::Allocate(size); }
+    static void operator delete(void* ptr) noexcept { TaskArena::Deallocate(ptr); }
+    static void* operator new(size_t size, std::align_val_t align) { return ::operator new(size, align); }
+    static void operator delete(void* ptr, std::align_val_t align) noexcept { ::operator delete(ptr, align); }
+
+    void AddRef()
+    {
+        m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    void Release()
+    {
+        if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+    template<typename... Args>
+    void SetValue(Args&&... args)
+    {
+        m_result.template emplace<1>(std::forward<Args>(args)...);
+        Publish();
+    }
+    void SetException(std::exception_ptr error)
+    {
+        m_result.template emplace<2>(std::move(error));
+        Publish();
+    }
+
+    void SetContinuation(Executor executor, Task&& task)
+    {
+        m_continuationExecutor = executor;
+        m_continuation = std::move(task);
+        uint8_t expected = Pending;
+        if (m_phase.compare_exchange_strong(expected, HasContinuation, std::memory_order_acq_rel)) return;
+        m_phase.store(Done, std::memory_order_release);
+        RunContinuation();
+    }
+
+    bool Ready() const
+    {
+        uint8_t phase = m_phase.load(std::memory_order_acquire);
+        return phase == HasResult || phase == Done;
+    }
+    void Wait()
+    {
+        while (!Ready())
+        {
+            auto key = m_ready.PrepareWait();
+            if (Ready())
+            {
+                m_ready.CancelWait();
+                break;
+            }
+            m_ready.Wait(key);
+        }
+    }
+
+    const Executor& GetExecutor() const { return m_executor; }
+    bool HasException() const { return m_result.index() == 2; }
+    std::exception_ptr Exception() const { return std::get<2>(m_result); }
+    Value& GetValue() { return std::get<1>(m_result); }
+};
+
+template<typename T, typename F>
+struct ThenResult
+{
+    using Type = std::invoke_result_t<F&, T>;
+};
+template<typename F>
+struct ThenResult<void, F>
+{
+    using Type = std::invoke_result_t<F&>;
+};
+
+// 执行 func 并把返回值或异常写入 promise
+template<typename R, typename F>
+void Fulfill(Promise<R>& promise, F&& func)
+{
+    try
+    {
+        if constexpr (std::is_void_v<R>)
+        {
+            func();
+            promise.SetValue();
+        }
+        else
+        {
+            promise.SetValue(func());
+        }
+    }
+    catch (...)
+    {
+        promise.SetException(std::current_exception());
+    }
+}
+}
+
+// 轻量的 future：一次分配的共享状态，可以阻塞 Get()，也可以用 Then 挂接后续任务，
+// 结果到达时后续任务被提交到线程池，整条依赖链上没有线程阻塞等待。只可移动，Get/Then/OnComplete 之后失效
+template<typename T>
+class Future
+{
+private:
+    using State = detail::FutureState<T>;
+    using Task = typename State::Task;
+
+    State* m_state = nullptr;
+
+    template<typename U>
+    friend class Promise;
+    template<typename U>
+    friend class Future;
+
+    explicit Future(State* state) : m_state(state)
+    {
+        m_state->AddRef();
+    }
+
+    State* Detach()
+    {
+        return std::exchange(m_state, nullptr);
+    }
+
+public:
+    Future() = default;
+    Future(Future&& other) noexcept : m_state(std::exchange(other.m_state, nullptr)) {}
+    Future& operator=(Future&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_state) m_state->Release();
+            m_state = std::exchange(other.m_state, nullptr);
+        }
+        return *this;
+    }
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+    ~Future()
+    {
+        if (m_state) m_state->Release();
+    }
+
+    bool Valid() const { return m_state != nullptr; }
+    bool Ready() const { return m_state && m_state->Ready(); }
+    void Wait() const { m_state->Wait(); }
+
+    // 阻塞等待并取出结果，任务抛出的异常在这里重新抛出
+    T Get()
+    {
+        m_state->Wait();
+        State* state = Detach();
+        struct Releaser
+        {
+            State* state;
+            ~Releaser() { state->Release(); }
+        } releaser{state};
+        if (state->HasException()) std::rethrow_exception(state->Exception());
+        if constexpr (std::is_void_v<T>) return;
+        else return std::move(state->GetValue());
+    }
+
+    // 结果到达后在 executor（默认为产生本结果的线程池）上执行 func(value)，返回 func 结果的 Future
+    // 本 Future 带异常时跳过 func，异常直接传给返回的 Future
+    template<typename F>
+    auto Then(F&& func)
+    {
+        Executor executor = m_state->GetExecutor();
+        return Then(executor, std::forward<F>(func));
+    }
+    template<typename F>
+    auto Then(Executor executor, F&& func)
+    {
+        using R = typename detail::ThenResult<T, std::decay_t<F>>::Type;
+        Promise<R> promise(executor);
+        Future<R> result = promise.GetFuture();
+        State* state = m_state;
+        state->SetContinuation(executor, Task(
+            [upstream = std::move(*this), promise = std::move(promise), func = std::forward<F>(func)]() mutable
+            {
+                State& source = *upstream.m_state;
+                if (source.HasException())
+                {
+                    promise.SetException(source.Exception());
+                    return;
+                }
+                if constexpr (std::is_void_v<T>)
+                {
+                    detail::Fulfill(promise, [&]{ return func(); });
+                }
+                else
+                {
+                    detail::Fulfill(promise, [&]{ return func(std::move(source.GetValue())); });
+                }
+            }));
+        return result;
+    }
+
+    // 结果到达后在产生本结果的线程池上执行 func(Future<T>)，传入的 Future 已就绪，Get() 不会阻塞
+    template<typename F>
+    void OnComplete(F&& func)
+    {
+        Executor executor = m_state->GetExecutor();
+        State* state = m_state;
+        state->SetContinuation(executor, Task(
+            [ready = std::move(*this), func = std::forward<F>(func)]() mutable
+            {
+                func(std::move(ready));
+            }));
+    }
+};
+
+// 与 Future 配对的写入端；未写入结果就销毁时，Future 得到 broken_promise 异常
+template<typename T>
+class Promise
+{
+private:
+    using State = detail::FutureState<T>;
+
+    State* m_state;
+    bool m_satisfied = false;
+    bool m_retrieved = false;
+
+public:
+    // executor 为结果到达后默认执行后续任务的线程池
+    explicit Promise(Executor executor = Executor()) : m_state(new State(executor))
+    {
+        m_state->AddRef();
+    }
+    Promise(Promise&& other) noexcept
+        : m_state(std::exchange(other.m_state, nullptr)),
+          m_satisfied(other.m_satisfied),
+          m_retrieved(other.m_retrieved)
+    {
+    }
+    Promise& operator=(Promise&&) = delete;
+    Promise(const Promise&) = delete;
+    Promise& operator=(const Promise&) = delete;
+    ~Promise()
+    {
+        if (!m_state) return;
+        if (!m_satisfied)
+        {
+            m_state->SetException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+        m_state->Release();
+    }
+
+    // 只能调用一次
+    Future<T> GetFuture()
+    {
+        if (m_retrieved) throw std::future_error(std::future_errc::future_already_retrieved);
+        m_retrieved = true;
+        return Future<T>(m_state);
+    }
+
+    template<typename... Args>
+    void SetValue(Args&&... args)
+    {
+        if (m_satisfied) throw std::future_error(std::future_errc::promise_already_satisfied);
+        m_satisfied = true;
+        m_state->SetValue(std::forward<Args>(args)...);
+    }
+    void SetException(std::exception_ptr error)
+    {
+        if (m_satisfied) throw std::future_error(std::future_errc::promise_already_satisfied);
+        m_satisfied = true;
+        m_state->SetException(std::move(error));
+    }
+};
+
+// 把可调用对象及参数打包成一个任务和对应的 Future，Future 的后续任务默认在 executor 上执行
+// promise 与参数内联在任务中，整个过程只有共享状态一次分配
+template<typename TaskType, typename F, typename... Args>
+auto PackageFutureTask(Executor executor, F&& func, Args&&... args)
+{
+    using ReturnType = std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>;
+
+    Promise<ReturnType> promise(executor);
+    Future<ReturnType> future = promise.GetFuture();
+    TaskType task([promise = std::move(promise),
+                   func = std::forward<F>(func),
+                   args = std::make_tuple(std::forward<Args>(args)...)]() mutable
+    {
+        detail::Fulfill(promise, [&]() -> ReturnType { return std::apply(func, args); });
+    });
+    return std::make_pair(std::move(task), std::move(future));
+}
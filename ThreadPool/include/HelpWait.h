@@ -0,0 +1,44 @@
+#pragma once
+
+#include "./SyncQueue/EventCount.hpp"
+
+#include <chrono>
+
+// 等待方帮忙执行任务的等待循环，TaskGroup::Wait、ParallelFor 等并行算法与 TaskGraph::Run 共用
+// 线程池中暂时没有可以帮忙执行的任务时，两次重新检查线程池之间最多睡眠的时间：
+// 执行中的任务随时可能提交需要有人帮忙的任务，而提交不会唤醒等待方
+inline constexpr std::chrono::milliseconds HelpPollInterval{1};
+
+// 等待 done() 成立，期间先用 runOwn() 执行等待方自己的任务（执行了返回 true），再执行线程池中的待处理任务，
+// 都没有时在 changed 上睡眠到完成方通知或超过 HelpPollInterval
+// 登记为等待者后再检查一次 done 与自己的任务，避免与完成方之间丢失唤醒；
+// 完成方在 done 成立后、以及产生新的自己的任务后都必须调用 changed.NotifyAll()
+template<typename Pool, typename Done, typename RunOwn>
+void HelpUntil(Pool& pool, EventCount& changed, Done&& done, RunOwn&& runOwn)
+{
+    while (!done())
+    {
+        if (runOwn()) continue;
+        if (pool.RunPendingTask()) continue;
+
+        auto key = changed.PrepareWait();
+        if (done())
+        {
+            changed.CancelWait();
+            break;
+        }
+        if (runOwn())
+        {
+            changed.CancelWait(); // 登记期间执行的任务至多让完成方多做一次无用的唤醒
+            continue;
+        }
+        changed.Wait(key, std::chrono::steady_clock::now() + HelpPollInterval);
+    }
+}
+
+// 等待方没有自己的任务列表，只帮忙执行线程池中的待处理任务
+template<typename Pool, typename Done>
+void HelpUntil(Pool& pool, EventCount& changed, Done&& done)
+{
+    HelpUntil(pool, changed, done, []{ return false; });
+}
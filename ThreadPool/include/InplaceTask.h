@@ -0,0 +1,201 @@
+#pragma once
+
+#include "TaskArena.h"
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// 任务对象内联存储的字节数，可在编译时通过 -DASUKA_TASK_INLINE_SIZE=N 调整
+#ifndef ASUKA_TASK_INLINE_SIZE
+#define ASUKA_TASK_INLINE_SIZE 48
+#endif
+inline constexpr size_t TaskInlineSize = ASUKA_TASK_INLINE_SIZE;
+
+// 只可移动的 void() 任务类型，带小对象优化
+// 捕获不超过 Capacity 字节且可无异常移动的可调用对象直接存放在任务内部，不发生堆分配；
+// 更大的可调用对象存放在当前线程的 TaskArena 中（见 TaskArena.h）。与 std::function 不同，可以保存只可移动的可调用对象
+template<size_t Capacity>
+class InplaceTask
+{
+private:
+    struct Ops
+    {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src) noexcept; // 移动到 dst 并销毁 src
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename F>
+    static constexpr bool FitsInline =
+        sizeof(F) <= Capacity
+        && alignof(F) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible_v<F>;
+
+    template<typename F>
+    struct InlineOps
+    {
+        static F* Get(void* storage) { return std::launder(reinterpret_cast<F*>(storage)); }
+        static void Invoke(void* storage) { (*Get(storage))(); }
+        static void Move(void* dst, void* src) noexcept
+        {
+            ::new (dst) F(std::move(*Get(src)));
+            Get(src)->~F();
+        }
+        static void Destroy(void* storage) noexcept { Get(storage)->~F(); }
+        static constexpr Ops Table{&Invoke, &Move, &Destroy};
+    };
+
+    template<typename F>
+    struct HeapOps
+    {
+        static F*& Get(void* storage) { return *std::launder(reinterpret_cast<F**>(storage)); }
+        static void Invoke(void* storage) { (*Get(storage))(); }
+        static void Move(void* dst, void* src) noexcept
+        {
+            ::new (dst) F*(Get(src));
+        }
+        static void Destroy(void* storage) noexcept { ArenaDelete(Get(storage)); }
+        static constexpr Ops Table{&Invoke, &Move, &Destroy};
+    };
+
+    alignas(std::max_align_t) unsigned char m_storage[Capacity];
+    const Ops* m_ops;
+
+    void Reset() noexcept
+    {
+        if (m_ops)
+        {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+public:
+    static_assert(Capacity >= sizeof(void*), "InplaceTask capacity must hold at least a pointer");
+
+    InplaceTask() noexcept : m_ops(nullptr) {}
+    InplaceTask(std::nullptr_t) noexcept : m_ops(nullptr) {}
+
+    template<typename F,
+             typename D = std::decay_t<F>,
+             typename = std::enable_if_t<!std::is_same_v<D, InplaceTask>
+                                         && std::is_invocable_v<D&>>>
+    InplaceTask(F&& func) : m_ops(nullptr)
+    {
+        if constexpr (FitsInline<D>)
+        {
+            ::new (static_cast<void*>(m_storage)) D(std::forward<F>(func));
+            m_ops = &InlineOps<D>::Table;
+        }
+        else
+        {
+            ::new (static_cast<void*>(m_storage)) D*(ArenaNew<D>(std::forward<F>(func)));
+            m_ops = &HeapOps<D>::Table;
+        }
+    }
+
+    InplaceTask(InplaceTask&& other) noexcept : m_ops(other.m_ops)
+    {
+        if (m_ops)
+        {
+            m_ops->move(m_storage, other.m_storage);
+            other.m_ops = nullptr;
+        }
+    }
+    InplaceTask& operator=(InplaceTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            if (other.m_ops)
+            {
+                m_ops = other.m_ops;
+                m_ops->move(m_storage, other.m_storage);
+                other.m_ops = nullptr;
+            }
+        }
+        return *this;
+    }
+    InplaceTask& operator=(std::nullptr_t) noexcept
+    {
+        Reset();
+        return *this;
+    }
+    InplaceTask(const InplaceTask&) = delete;
+    InplaceTask& operator=(const InplaceTask&) = delete;
+    ~InplaceTask() { Reset(); }
+
+    // 与 std::function 一致，调用空任务抛出 std::bad_function_call
+    void operator()()
+    {
+        if (!m_ops) throw std::bad_function_call();
+        m_ops->invoke(m_storage);
+    }
+    explicit operator bool() const noexcept { return m_ops != nullptr; }
+};
+
+// 带返回值的任务：promise、可调用对象与参数放在同一个对象里，整体内联进 Task，
+// 取代 make_shared<packaged_task> + bind + 再包一层 std::function 的做法
+template<typename R, typename F, typename... Args>
+class PromiseTask
+{
+private:
+    std::promise<R> m_promise;
+    F m_func;
+    std::tuple<Args...> m_args;
+
+public:
+    template<typename Fn, typename... As>
+    PromiseTask(std::promise<R>&& promise, Fn&& func, As&&... args)
+        : m_promise(std::move(promise)),
+          m_func(std::forward<Fn>(func)),
+          m_args(std::forward<As>(args)...)
+    {}
+
+    // 不执行可调用对象，直接以 error 完成 future（任务在执行前被取消时使用）
+    void Abandon(std::exception_ptr error)
+    {
+        m_promise.set_exception(std::move(error));
+    }
+
+    void operator()()
+    {
+        try
+        {
+            // 与 std::bind 一致，绑定的参数以左值传入
+            if constexpr (std::is_void_v<R>)
+            {
+                std::apply(m_func, m_args);
+                m_promise.set_value();
+            }
+            else
+            {
+                m_promise.set_value(std::apply(m_func, m_args));
+            }
+        }
+        catch (...)
+        {
+            m_promise.set_exception(std::current_exception());
+        }
+    }
+};
+
+// 将可调用对象和参数打包成队列中的 TaskType，返回任务本身以及与之关联的 future
+template<typename TaskType, typename F, typename... Args>
+auto PackageTask(F&& func, Args&&... args)
+{
+    using ReturnType = std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>;
+    using Wrapper = PromiseTask<ReturnType, std::decay_t<F>, std::decay_t<Args>...>;
+
+    // promise 的共享状态同样从 TaskArena 分配
+    std::promise<ReturnType> promise(std::allocator_arg, ArenaAllocator<char>());
+    std::future<ReturnType> result = promise.get_future();
+    TaskType task(Wrapper(std::move(promise), std::forward<F>(func), std::forward<Args>(args)...));
+    return std::make_pair(std::move(task), std::move(result));
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "HelpWait.h"
+#include "WorkStealingThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+// 基于 WorkStealingThreadPool 的并行算法
+// 区间采用惰性二分拆分：执行者按逐步翻倍的小块顺序处理自己的区间，每处理完一块检查一次
+// 是否有线程缺活（WantsWork），有才把剩余区间的后一半作为新任务交出去，
+// 因此调用者无需指定粒度，任务数量随实际空闲线程数自适应，极小的循环体也不会被任务开销淹没
+// 调用线程会先处理整个区间，再在等待期间执行池中的待处理任务，没有可执行的任务时睡眠到最后一个区间任务结束
+// 循环体抛出的第一个异常会在所有已拆分的任务结束后在调用线程重新抛出
+namespace detail
+{
+template<typename Leaf>
+struct ParallelState
+{
+    ParallelState(WorkStealingThreadPool& p, Leaf& l, size_t chunk)
+        : pool(p), leaf(l), maxChunk(chunk), pending(1), failed(false)
+    {}
+
+    WorkStealingThreadPool& pool;
+    Leaf& leaf;                  // leaf(begin, end) 顺序处理 [begin, end)
+    size_t maxChunk;             // 两次拆分检查之间最多连续处理的元素数
+    std::atomic<size_t> pending; // 尚未结束的区间任务数
+    std::atomic<bool> failed;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    EventCount finished;         // pending 归零时唤醒等待的调用者
+};
+
+// 区间任务共享状态：最后一个任务在计数归零之后还要唤醒调用者，此时调用者可能已经返回
+template<typename Leaf>
+using ParallelStatePtr = std::shared_ptr<ParallelState<Leaf>>;
+
+template<typename Leaf>
+void RunRange(const ParallelStatePtr<Leaf>& state, size_t begin, size_t end)
+{
+    try
+    {
+        size_t chunk = 1;
+        while (begin < end && !state->failed.load(std::memory_order_relaxed))
+        {
+            if (end - begin > chunk && state->pool.WantsWork())
+            {
+                size_t mid = begin + (end - begin) / 2;
+                WorkStealingThreadPool::Task task([state, mid, end]{ RunRange(state, mid, end); });
+                state->pending.fetch_add(1, std::memory_order_relaxed);
+                if (state->pool.TryAddTask(std::move(task)))
+                {
+                    end = mid;
+                }
+                else
+                {
+                    state->pending.fetch_sub(1, std::memory_order_relaxed); // 交不出去就自己做
+                }
+            }
+            size_t stop = std::min(end, begin + chunk);
+            state->leaf(begin, stop);
+            begin = stop;
+            chunk = std::min(chunk * 2, state->maxChunk);
+        }
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(state->errorMutex);
+        if (!state->error) state->error = std::current_exception();
+        state->failed.store(true, std::memory_order_relaxed);
+    }
+    if (state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) state->finished.NotifyAll();
+}
+
+// 并行处理 [first, last)，调用线程参与执行并在全部完成后返回
+template<typename Leaf>
+void ParallelRun(WorkStealingThreadPool& pool, size_t first, size_t last, Leaf& leaf)
+{
+    if (first >= last) return;
+
+    // 每个线程约分到 8 块，块再大就失去了拆分的机会
+    size_t maxChunk = std::max<size_t>(1, (last - first) / (pool.ThreadNum() * 8));
+    auto state = std::make_shared<ParallelState<Leaf>>(pool, leaf, maxChunk);
+    RunRange(state, first, last);
+    HelpUntil(pool, state->finished, [&state]{ return state->pending.load(std::memory_order_acquire) == 0; });
+    if (state->error) std::rethrow_exception(state->error);
+}
+}
+
+// 对 [first, last) 中的每个下标调用 body(i)
+template<typename F>
+void ParallelFor(WorkStealingThreadPool& pool, size_t first, size_t last, F&& body)
+{
+    auto leaf = [&body](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i) body(i);
+    };
+    detail::ParallelRun(pool, first, last, leaf);
+}
+
+// 计算 reduce(identity, map(first), ..., map(last - 1))
+// reduce 须满足结合律与交换律，identity 须为 reduce 的单位元；各块的部分结果合并顺序不确定
+template<typename T, typename Map, typename Reduce>
+T ParallelReduce(WorkStealingThreadPool& pool, size_t first, size_t last, T identity, Map&& map, Reduce&& reduce)
+{
+    std::mutex resultMutex;
+    T result = identity;
+    auto leaf = [&](size_t begin, size_t end)
+    {
+        T partial = identity;
+        for (size_t i = begin; i < end; ++i) partial = reduce(std::move(partial), map(i));
+        std::lock_guard<std::mutex> lock(resultMutex);
+        result = reduce(std::move(result), std::move(partial));
+    };
+    detail::ParallelRun(pool, first, last, leaf);
+    return result;
+}
+
+// 与 std::transform 相同：*(out + i) = op(*(first + i))，返回输出区间的末尾
+// 输入与输出都必须是随机访问迭代器
+template<typename InputIt, typename OutputIt, typename UnaryOp>
+OutputIt ParallelTransform(WorkStealingThreadPool& pool, InputIt first, InputIt last, OutputIt out, UnaryOp&& op)
+{
+    static_assert(std::is_base_of<std::random_access_iterator_tag,
+                                  typename std::iterator_traits<InputIt>::iterator_category>::value,
+                  "ParallelTransform requires random access input iterators");
+    static_assert(std::is_base_of<std::random_access_iterator_tag,
+                                  typename std::iterator_traits<OutputIt>::iterator_category>::value,
+                  "ParallelTransform requires random access output iterators");
+
+    auto count = static_cast<size_t>(std::distance(first, last));
+    auto leaf = [&](size_t begin, size_t end)
+    {
+        auto in = first + static_cast<std::ptrdiff_t>(begin);
+        auto dst = out + static_cast<std::ptrdiff_t>(begin);
+        for (size_t i = begin; i < end; ++i, ++in, ++dst) *dst = op(*in);
+    };
+    detail::ParallelRun(pool, 0, count, leaf);
+    return out + static_cast<std::ptrdiff_t>(count);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "./SyncQueue/Backpressure.hpp"
+
+// co_await pool.Schedule() 返回的等待体：挂起当前协程，把协程句柄作为任务放入线程池，
+// 由工作线程直接 resume。句柄只有一个指针大小，内联在 Task 中，不经过 std::function 也不分配内存
+// 不依赖 <coroutine>，await_suspend 接受任意协程句柄类型，因此线程池头文件仍可在 C++17 下编译
+template<typename Pool>
+class ScheduleAwaiter
+{
+private:
+    Pool& m_pool;
+
+public:
+    explicit ScheduleAwaiter(Pool& pool) : m_pool(pool) {}
+
+    // 已经在本线程池的工作线程上时直接继续执行，不重新入队：
+    // 有界队列满时工作线程向自己的队列提交会阻塞，所有工作线程都这样做就会死锁
+    bool await_ready() const { return m_pool.InWorkerThread(); }
+
+    // 线程池已停止或任务被背压策略拒绝时不挂起，协程在当前线程继续执行
+    // CallerRuns 时协程已经在 AddTask 内恢复执行，这里只能返回 true
+    template<typename Handle>
+    bool await_suspend(Handle handle)
+    {
+        if (!m_pool.IsRunning()) return false;
+        return Accepted(m_pool.AddTask([handle]() mutable { handle.resume(); }));
+    }
+
+    void await_resume() const noexcept {}
+};
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// 每线程按尺寸分级的回收分配器，承载放不进内联存储的任务闭包以及 promise / Future 的共享状态
+// 每个块前有一个头部记录所属线程的 arena：
+//   - 在分配线程上释放时直接挂回该线程的空闲链表，不加锁、不经过全局分配器
+//   - 在其他线程上释放时压入所属 arena 的无锁链表，由所属线程下次取不到空闲块时整批收回
+// 超过最大级别的大小、或通过 TaskArena::SetEnabled(false) 关闭后分配的块直接使用 ::operator new
+// 线程退出时缓存的空闲块归还给全局分配器，仍在其他线程手中的块在最后一个归还时连同 arena 一起释放
+class TaskArena
+{
+public:
+    // 尺寸级别：64 / 128 / 256 / 512 字节
+    static constexpr size_t ClassCount = 4;
+    static constexpr size_t MinClassSize = 64;
+    static constexpr size_t MaxClassSize = MinClassSize << (ClassCount - 1);
+    // 每个级别最多缓存的空闲块数，超出部分归还给全局分配器
+    static constexpr size_t MaxCachedBlocks = 128;
+
+    static void* Allocate(size_t size)
+    {
+        size_t cls = ClassOf(size);
+        if (cls < ClassCount && Enabled())
+        {
+            if (TaskArena* arena = Local()) return arena->AllocateBlock(cls);
+        }
+        return AllocateUnowned(size);
+    }
+
+    static void Deallocate(void* ptr) noexcept
+    {
+        if (!ptr) return;
+        BlockHeader* header = HeaderOf(ptr);
+        TaskArena* owner = header->owner;
+        if (!owner)
+        {
+            ::operator delete(header);
+        }
+        else if (owner == t_arena)
+        {
+            owner->FreeLocal(header);
+        }
+        else
+        {
+            owner->FreeRemote(header);
+        }
+    }
+
+    // 运行时开关，默认开启；关闭后新分配改走全局分配器，已分配的块仍按原路径归还
+    static void SetEnabled(bool enabled) { EnabledFlag().store(enabled, std::memory_order_relaxed); }
+    static bool Enabled() { return EnabledFlag().load(std::memory_order_relaxed); }
+
+private:
+    // 头部按 max_align_t 对齐，用户区与 ::operator new 的返回值具有相同的对齐保证
+    struct alignas(std::max_align_t) BlockHeader
+    {
+        TaskArena* owner;   // 所属 arena，大块或关闭时为 nullptr
+        uint32_t sizeClass;
+    };
+    // 空闲块复用用户区存放链表指针
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    // 所属线程已退出时 m_remote 的取值，之后的跨线程释放直接归还全局分配器
+    static FreeBlock* Orphaned() { return reinterpret_cast<FreeBlock*>(uintptr_t(1)); }
+
+    // 线程局部的持有者，析构时把 arena 交给仍在外面的块
+    struct Holder
+    {
+        TaskArena* arena = nullptr;
+        ~Holder()
+        {
+            t_arena = nullptr;
+            t_exited = true;
+            if (arena) arena->Orphan();
+        }
+    };
+
+    static inline thread_local TaskArena* t_arena = nullptr;
+    static inline thread_local bool t_exited = false;
+
+    FreeBlock* m_free[ClassCount] = {};
+    size_t m_cached[ClassCount] = {};
+    size_t m_live = 0;                          // 已分配出去且尚未回到本线程的块数，只由所属线程修改
+    alignas(64) std::atomic<FreeBlock*> m_remote{nullptr};
+    std::atomic<size_t> m_orphanRefs{0};        // 所属线程退出后仍未归还的块数，加上退出线程自己的一个引用
+
+    static std::atomic<bool>& EnabledFlag()
+    {
+        static std::atomic<bool> enabled{true};
+        return enabled;
+    }
+
+    static size_t ClassOf(size_t size)
+    {
+        size_t cls = 0;
+        size_t classSize = MinClassSize;
+        while (cls < ClassCount && classSize < size)
+        {
+            classSize <<= 1;
+            ++cls;
+        }
+        return cls;
+    }
+
+    static BlockHeader* HeaderOf(void* ptr) { return static_cast<BlockHeader*>(ptr) - 1; }
+    static void* PayloadOf(BlockHeader* header) { return header + 1; }
+
+    static void* AllocateUnowned(size_t size)
+    {
+        BlockHeader* header = static_cast<BlockHeader*>(::operator new(sizeof(BlockHeader) + size));
+        header->owner = nullptr;
+        header->sizeClass = ClassCount;
+        return PayloadOf(header);
+    }
+
+    // 线程退出后（其他 thread_local 对象析构期间）不再创建 arena，改走全局分配器
+    static TaskArena* Local()
+    {
+        if (t_arena) return t_arena;
+        if (t_exited) return nullptr;
+        thread_local Holder holder;
+        holder.arena = new TaskArena();
+        t_arena = holder.arena;
+        return t_arena;
+    }
+
+    void* AllocateBlock(size_t cls)
+    {
+        if (!m_free[cls]) ReclaimRemote();
+        FreeBlock* block = m_free[cls];
+        BlockHeader* header;
+        if (block)
+        {
+            m_free[cls] = block->next;
+            --m_cached[cls];
+            header = HeaderOf(block);
+        }
+        else
+        {
+            header = static_cast<BlockHeader*>(::operator new(sizeof(BlockHeader) + (MinClassSize << cls)));
+            header->owner = this;
+            header->sizeClass = static_cast<uint32_t>(cls);
+        }
+        ++m_live;
+        return PayloadOf(header);
+    }
+
+    void FreeLocal(BlockHeader* header) noexcept
+    {
+        --m_live;
+        Cache(header);
+    }
+
+    void Cache(BlockHeader* header) noexcept
+    {
+        size_t cls = header->sizeClass;
+        if (m_cached[cls] >= MaxCachedBlocks)
+        {
+            ::operator delete(header);
+            return;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(PayloadOf(header));
+        block->next = m_free[cls];
+        m_free[cls] = block;
+        ++m_cached[cls];
+    }
+
+    // 整批取走其他线程归还的块，按级别挂回空闲链表
+    void ReclaimRemote() noexcept
+    {
+        if (!m_remote.load(std::memory_order_relaxed)) return;
+        FreeBlock* block = m_remote.exchange(nullptr, std::memory_order_acquire);
+        while (block)
+        {
+            FreeBlock* next = block->next;
+            --m_live;
+            Cache(HeaderOf(block));
+            block = next;
+        }
+    }
+
+    void FreeRemote(BlockHeader* header) noexcept
+    {
+        FreeBlock* block = static_cast<FreeBlock*>(PayloadOf(header));
+        FreeBlock* head = m_remote.load(std::memory_order_relaxed);
+        while (head != Orphaned())
+        {
+            block->next = head;
+            if (m_remote.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed))
+            {
+                return;
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        ::operator delete(header);
+        ReleaseOrphanRef();
+    }
+
+    // 所属线程退出：释放缓存的空闲块，标记为孤立后由最后一个归还的块（或本线程）释放 arena
+    void Orphan() noexcept
+    {
+        for (size_t cls = 0; cls < ClassCount; ++cls)
+        {
+            while (FreeBlock* block = m_free[cls])
+            {
+                m_free[cls] = block->next;
+                ::operator delete(HeaderOf(block));
+            }
+            m_cached[cls] = 0;
+        }
+        // 先发布引用数再标记孤立，看到孤立标记的线程一定能看到正确的计数
+        m_orphanRefs.store(m_live + 1, std::memory_order_relaxed);
+        FreeBlock* block = m_remote.exchange(Orphaned(), std::memory_order_acq_rel);
+        while (block)
+        {
+            FreeBlock* next = block->next;
+            ::operator delete(HeaderOf(block));
+            ReleaseOrphanRef();
+            block = next;
+        }
+        ReleaseOrphanRef();
+    }
+
+    void ReleaseOrphanRef() noexcept
+    {
+        if (m_orphanRefs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+};
+
+// 在 TaskArena 上构造与销毁单个对象；超出 max_align_t 对齐要求的类型直接使用 new / delete
+template<typename T, typename... Args>
+T* ArenaNew(Args&&... args)
+{
+    if constexpr (alignof(T) > alignof(std::max_align_t))
+    {
+        return new T(std::forward<Args>(args)...);
+    }
+    else
+    {
+        void* memory = TaskArena::Allocate(sizeof(T));
+        try
+        {
+            return ::new (memory) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            TaskArena::Deallocate(memory);
+            throw;
+        }
+    }
+}
+
+template<typename T>
+void ArenaDelete(T* ptr) noexcept
+{
+    if constexpr (alignof(T) > alignof(std::max_align_t))
+    {
+        delete ptr;
+    }
+    else if (ptr)
+    {
+        ptr->~T();
+        TaskArena::Deallocate(ptr);
+    }
+}
+
+// 满足标准分配器要求的适配器，供 std::promise(std::allocator_arg, ...) 等接口使用
+template<typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        if constexpr (alignof(T) > alignof(std::max_align_t))
+        {
+            return std::allocator<T>().allocate(n);
+        }
+        else
+        {
+            if (n > static_cast<size_t>(-1) / sizeof(T)) throw std::bad_array_new_length();
+            return static_cast<T*>(TaskArena::Allocate(n * sizeof(T)));
+        }
+    }
+    void deallocate(T* ptr, size_t n) noexcept
+    {
+        if constexpr (alignof(T) > alignof(std::max_align_t))
+        {
+            std::allocator<T>().deallocate(ptr, n);
+        }
+        else
+        {
+            TaskArena::Deallocate(ptr);
+        }
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>&) const noexcept { return false; }
+};
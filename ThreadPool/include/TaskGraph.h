@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Future.h"
+#include "HelpWait.h"
+#include "WorkStealingThreadPool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 有向无环任务图：先 AddNode / AddEdge 建图，再在 WorkStealingThreadPool 上运行，同一张图可以反复运行
+// 每个节点有一个原子汇合计数，初值为前驱数量；节点完成时给每个后继减一，
+// 减到零的后继由完成它的工作线程放入自己的本地队列，没有中心调度器，也没有全局锁
+// 任一节点抛出异常后，尚未开始的节点被跳过，第一个异常在运行结束时传给调用者
+// 同一时刻只能有一次运行，运行期间不能修改图；图对象不可复制或移动（运行中的任务持有它的地址）
+class TaskGraph
+{
+public:
+    using Task = InplaceTask<TaskInlineSize>;
+    using NodeId = size_t;
+
+private:
+    std::vector<Task> m_work;                     // 节点的工作，每次运行都会调用一次，不会被消耗
+    std::vector<std::vector<NodeId>> m_successors;
+    std::vector<uint32_t> m_predecessors;         // 每个节点的前驱数量
+    std::vector<NodeId> m_roots;                  // 没有前驱的节点，校验时计算
+    bool m_validated = true;
+
+    // 单次运行的状态
+    std::unique_ptr<std::atomic<uint32_t>[]> m_joins;
+    size_t m_joinCount = 0;
+    std::atomic<size_t> m_remaining{0};
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_failed{false};
+    std::mutex m_errorMutex;
+    std::exception_ptr m_error;
+    WorkStealingThreadPool* m_pool = nullptr;
+    std::unique_ptr<Promise<void>> m_promise;
+    // 运行结束时唤醒 Run 中等待的调用者；由 Finish 持有一份引用，写入结果后图可能已被销毁
+    std::shared_ptr<EventCount> m_finished = std::make_shared<EventCount>();
+
+    void Validate();
+    void RunNode(NodeId node);
+    void Finish();
+
+public:
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // 添加一个节点，返回其编号（从 0 开始连续分配）
+    NodeId AddNode(Task work);
+    // 添加依赖：to 在 from 完成之后才开始；编号无效或 from == to 时抛出 std::invalid_argument
+    void AddEdge(NodeId from, NodeId to);
+
+    size_t NodeCount() const { return m_work.size(); }
+
+    // 开始运行并立即返回，全部节点结束后返回的 Future 就绪（或带第一个节点异常）
+    // 图中有环时抛出 std::logic_error；线程池已停止时返回的 Future 带 broken_promise 异常
+    Future<void> RunAsync(WorkStealingThreadPool& pool);
+
+    // 运行并等待完成，调用线程在等待期间执行池中的待处理任务；节点抛出的第一个异常在这里重新抛出
+    void Run(WorkStealingThreadPool& pool);
+};
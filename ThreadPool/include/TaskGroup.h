@@ -0,0 +1,169 @@
+#pragma once
+
+#include "./SyncQueue/EventCount.hpp"
+#include "Cancellation.h"
+#include "HelpWait.h"
+#include "InplaceTask.h"
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// 一组可以一起等待、一起取消的任务，适用于三种线程池（Pool 需提供 Task、TryAddTask 与 RunPendingTask）
+// Run 把任务放进组自己的待执行列表，再向线程池提交一个只负责从列表取一个任务执行的“票据”：
+//   - Wait 的调用者先从列表中取本组的任务自己执行，列表空了再执行线程池中的其他待处理任务，
+//     在工作线程内等待子任务不会占着线程空等，所有工作线程都在等待时也不会死锁
+//   - 被等待者取走的任务，其票据出队后发现列表为空直接返回；票据持有共享状态，组销毁后仍可安全执行
+//   - 票据用 TryAddTask 提交，队列满时不阻塞提交者（否则工作线程全都阻塞在提交上就会死锁），
+//     任务留在列表中由其他票据或 Wait 的调用者执行
+// 任一任务抛出异常后组被取消，尚未开始的任务被跳过，第一个异常在 Wait 中重新抛出
+// 组对象不可复制或移动；析构时等待全部任务结束（不抛出异常）
+template<typename Pool>
+class TaskGroup
+{
+public:
+    using Task = typename Pool::Task;
+
+private:
+    struct State
+    {
+        std::mutex mutex;
+        std::deque<Task> pending;            // 尚未开始的任务
+        std::atomic<size_t> unfinished{0};   // 已 Run 尚未结束（排队中与执行中）的任务数
+        CancellationSource cancel;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        EventCount changed;                  // 有新任务或全部结束时唤醒 Wait
+
+        bool TakeFront(Task& task)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (pending.empty()) return false;
+            task = std::move(pending.front());
+            pending.pop_front();
+            return true;
+        }
+        // 等待者从尾部取，最近放入的任务数据更可能还在缓存中
+        bool TakeBack(Task& task)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (pending.empty()) return false;
+            task = std::move(pending.back());
+            pending.pop_back();
+            return true;
+        }
+
+        void Execute(Task& task)
+        {
+            if (!cancel.IsCancelled())
+            {
+                try
+                {
+                    task();
+                }
+                catch (...)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (!error) error = std::current_exception();
+                    }
+                    cancel.Cancel();
+                }
+            }
+            task = nullptr; // 闭包在计为结束之前销毁，Wait 返回后不再引用调用者的数据
+            Finish(1);
+        }
+
+        void Finish(size_t count)
+        {
+            if (unfinished.fetch_sub(count, std::memory_order_acq_rel) == count) changed.NotifyAll();
+        }
+    };
+
+    Pool& m_pool;
+    std::shared_ptr<State> m_state;
+
+    // 等待全部任务结束，返回第一个异常
+    std::exception_ptr Join()
+    {
+        State& state = *m_state;
+        Task task;
+        // 先执行本组的任务，再执行线程池中的其他任务，剩下的任务都在其他线程上执行时睡眠到有新任务或全部结束
+        HelpUntil(m_pool, state.changed,
+                  [&state]{ return state.unfinished.load(std::memory_order_acquire) == 0; },
+                  [&state, &task]
+                  {
+                      if (!state.TakeBack(task)) return false;
+                      state.Execute(task);
+                      return true;
+                  });
+
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(state.errorMutex);
+            error = std::exchange(state.error, nullptr);
+        }
+        // 已取消的组换一份新的状态，之后可以继续使用；旧状态由尚未出队的票据持有到它们执行完
+        if (state.cancel.IsCancelled()) m_state = std::make_shared<State>();
+        return error;
+    }
+
+public:
+    explicit TaskGroup(Pool& pool) : m_pool(pool), m_state(std::make_shared<State>()) {}
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    ~TaskGroup() { Join(); }
+
+    // 添加一个任务，不会阻塞；组已取消时直接丢弃。线程池已停止时任务在 Wait（或析构）中由调用线程执行
+    template<typename F>
+    void Run(F&& func)
+    {
+        State& state = *m_state;
+        if (state.cancel.IsCancelled()) return;
+
+        state.unfinished.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.pending.emplace_back(std::forward<F>(func));
+        }
+        state.changed.NotifyAll();
+
+        Task ticket([state = m_state]
+        {
+            Task task;
+            if (state->TakeFront(task)) state->Execute(task);
+        });
+        m_pool.TryAddTask(std::move(ticket));
+    }
+
+    // 等待本组全部任务结束，等待期间调用线程执行本组与线程池中的待处理任务；任务抛出的第一个异常在这里重新抛出
+    // 可以在线程池的工作线程内调用，也可以嵌套使用
+    void Wait()
+    {
+        if (std::exception_ptr error = Join()) std::rethrow_exception(error);
+    }
+
+    // 取消尚未开始的任务；正在执行的任务可以通过 IsCancelled() 或 Token() 自行提前结束
+    void Cancel()
+    {
+        State& state = *m_state;
+        state.cancel.Cancel();
+        std::deque<Task> dropped;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            dropped.swap(state.pending);
+        }
+        size_t count = dropped.size();
+        dropped.clear();
+        if (count > 0) state.Finish(count);
+    }
+
+    bool IsCancelled() const { return m_state->cancel.IsCancelled(); }
+
+    // 本组的取消令牌，可以传给 TaskGuard，让提交到其他地方的任务随本组一起取消
+    CancellationToken Token() const { return m_state->cancel.Token(); }
+};
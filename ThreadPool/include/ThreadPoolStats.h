@@ -0,0 +1,55 @@
+#pragma once
+
+#include "./SyncQueue/WorkerCounters.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 单个工作线程的统计快照
+struct WorkerStats
+{
+    uint64_t executed = 0;
+    uint64_t stolen = 0;
+    uint64_t stealAttempts = 0;
+    uint64_t stealFailures = 0;
+    uint64_t idleNs = 0;
+    uint64_t busyNs = 0;
+    size_t queueHighWatermark = 0; // 该线程自己的队列（仅工作窃取线程池）
+
+    void Load(const WorkerCounters& counters)
+    {
+        executed = counters.executed.load(std::memory_order_relaxed);
+        stolen = counters.stolen.load(std::memory_order_relaxed);
+        stealAttempts = counters.stealAttempts.load(std::memory_order_relaxed);
+        stealFailures = counters.stealFailures.load(std::memory_order_relaxed);
+        idleNs = counters.idleNs.load(std::memory_order_relaxed);
+        busyNs = counters.busyNs.load(std::memory_order_relaxed);
+    }
+    WorkerStats& operator+=(const WorkerStats& other)
+    {
+        executed += other.executed;
+        stolen += other.stolen;
+        stealAttempts += other.stealAttempts;
+        stealFailures += other.stealFailures;
+        idleNs += other.idleNs;
+        busyNs += other.busyNs;
+        if (other.queueHighWatermark > queueHighWatermark) queueHighWatermark = other.queueHighWatermark;
+        return *this;
+    }
+};
+
+// 线程池统计快照，GetStats() 不停止工作线程，各计数分别读取，彼此之间不保证严格一致
+struct ThreadPoolStats
+{
+    std::vector<WorkerStats> workers; // 按工作线程（CacheThreadPool 为线程槽位）排列
+    WorkerStats total;                // workers 之和，queueHighWatermark 取最大值
+    size_t threadCount = 0;           // 当前线程数
+    size_t idleThreads = 0;           // 当前空闲（等待任务）的线程数
+    size_t standbyThreads = 0;        // 已退役、可一次唤醒重新激活的待命线程数（仅 CacheThreadPool）
+    size_t queueSize = 0;             // 当前排队任务数
+    size_t queueHighWatermark = 0;    // 排队任务数的历史最大值
+    uint64_t rejectedTasks = 0;       // 因队列满被拒绝或等待超时的任务数（背压策略）
+    uint64_t droppedTasks = 0;        // 按 DropOldest 被丢弃的排队任务数
+    uint64_t cancelledTasks = 0;      // 出队时取消令牌已触发或已过截止时间、未执行就被丢弃的任务数
+};
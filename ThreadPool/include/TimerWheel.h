@@ -0,0 +1,114 @@
+#pragma once
+
+#include "InplaceTask.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 定时器句柄，0 表示无效
+using TimerId = uint64_t;
+inline constexpr TimerId InvalidTimerId = 0;
+
+// 分层时间轮：6 层、每层 64 个槽，第 0 层一个槽对应一个 tick，第 L 层一个槽对应 64^L 个 tick，
+// 默认 1 ms 一个 tick 时可覆盖约 795 天，更远的定时器先放在最高层，逐层下放时再按真实到期时间归位
+// 插入、取消都是 O(1)：定时器节点保存在节点池中，用下标串成每个槽的双向链表，句柄带代数防止误取消已复用的节点
+// 到期的任务由一个定时线程交给 dispatch（通常是线程池的 TryAddTask），定时线程在第一次添加定时器时才启动；
+// dispatch 放不下时任务留在时间轮中，下一个 tick 重新派发，定时线程既不阻塞也不执行任务
+class TimerWheel
+{
+public:
+    using Task = InplaceTask<TaskInlineSize>;
+    using Clock = std::chrono::steady_clock;
+    // 接受任务时移走 task 并返回 true；返回 false 时 task 必须保持原样，由时间轮稍后重试
+    using Dispatcher = std::function<bool(Task&)>;
+
+    explicit TimerWheel(Dispatcher dispatch, Clock::duration resolution = std::chrono::milliseconds(1));
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // 在 when 时刻（向上取整到 tick）把 task 交给 dispatch，已停止时返回 InvalidTimerId
+    TimerId ScheduleAt(Clock::time_point when, Task&& task);
+    TimerId ScheduleAfter(Clock::duration delay, Task&& task)
+    {
+        return ScheduleAt(Clock::now() + delay, std::move(task));
+    }
+    // 从现在起每隔 period 执行一次 task；上一次还在排队或执行时跳过本次，同一任务不会并发执行
+    TimerId ScheduleEvery(Clock::duration period, Task&& task);
+
+    // 取消尚未到期的定时器，周期定时器取消后不再触发；已经交给线程池的任务不受影响
+    // 成功取消时返回 true
+    bool Cancel(TimerId id);
+
+    // 停止定时线程并丢弃所有未到期的定时器，之后的 Schedule* 返回 InvalidTimerId
+    void Stop();
+
+    // 未到期的定时器数量，包括等待重新派发的任务
+    size_t Pending() const;
+
+private:
+    static constexpr unsigned LevelBits = 6;
+    static constexpr unsigned LevelCount = 6;
+    static constexpr unsigned SlotsPerLevel = 1u << LevelBits;
+    static constexpr uint64_t SlotMask = SlotsPerLevel - 1;
+    static constexpr uint64_t MaxDelta = (uint64_t(1) << (LevelBits * LevelCount)) - 1;
+    static constexpr int32_t Nil = -1;
+
+    // 周期任务的可调用对象被多次执行，多次派发共享同一份状态
+    struct Periodic
+    {
+        Task task;
+        std::atomic<bool> queued{false}; // 已交给线程池、尚未执行完
+    };
+    struct PeriodicRun;
+
+    struct Node
+    {
+        uint64_t expires = 0;  // 到期 tick
+        uint64_t period = 0;   // 周期 tick，0 表示一次性
+        uint32_t generation = 0;
+        int32_t slot = Nil;    // 所在槽的全局编号，Nil 表示空闲节点
+        int32_t prev = Nil;
+        int32_t next = Nil;
+        Task task;
+        std::shared_ptr<Periodic> periodic;
+    };
+
+    Dispatcher m_dispatch;
+    const Clock::time_point m_start;
+    const Clock::duration m_resolution;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    bool m_stop = false;
+
+    std::vector<Node> m_nodes;
+    std::vector<int32_t> m_freeNodes;
+    int32_t m_heads[LevelCount * SlotsPerLevel];
+    uint64_t m_occupied[LevelCount]; // 每层非空槽的位图，用于快速找到下一次需要醒来的 tick
+    uint64_t m_now = 0;              // 已处理到的 tick
+    uint64_t m_wakeTick = UINT64_MAX; // 定时线程睡到哪个 tick，新定时器更早到期时才需要唤醒它
+    size_t m_pending = 0;
+
+    uint64_t ToTick(Clock::time_point when) const;
+    TimerId Insert(uint64_t expires, uint64_t period, Task&& task, std::shared_ptr<Periodic> periodic);
+    void Rearm(Task&& task);
+    int32_t AllocNode();
+    void FreeNode(int32_t index);
+    void Place(int32_t index);
+    void Unlink(int32_t index);
+    void Cascade(unsigned level, uint64_t slot);
+    void Expire(std::vector<Task>& due);
+    void Advance(uint64_t target, std::vector<Task>& due);
+    uint64_t NextWakeTick() const;
+    void Run();
+};
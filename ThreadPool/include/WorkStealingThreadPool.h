@@ -1,10 +1,20 @@
 #pragma once
 
 #include "./SyncQueue/WorkStealingSyncQueue.hpp"
+#include "./SyncQueue/IdleTracker.hpp"
+#include "Cancellation.h"
+#include "CpuTopology.h"
+#include "Future.h"
+#include "InplaceTask.h"
+#include "ScheduleAwaiter.h"
+#include "ThreadPoolStats.h"
+#include "TimerWheel.h"
 
 #include <atomic>
-#include <functional>
+#include <chrono>
 #include <future>
+#include <iterator>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -12,28 +22,111 @@
 class WorkStealingThreadPool
 {
 public:
-    using Task = std::function<void()>;
+    using Task = InplaceTask<TaskInlineSize>;
 
 private:
     std::vector<std::thread> m_workers;
-    SyncQueue<Task> m_taskQueue;
+    WorkStealingSyncQueue<Task> m_taskQueue;
     std::atomic<bool> m_running;
-    std::atomic<size_t> m_roundRobin;
+    std::atomic<uint64_t> m_cancelledTasks{0}; // 带 TaskGuard 的任务出队后被丢弃的数量
     std::once_flag m_flag;
     size_t m_threadnum;
+    WorkerPlacement m_placement;
+    std::vector<int> m_workerCpus; // 每个工作线程绑定的 CPU，不绑定时为空
+    std::unique_ptr<WorkerCounters[]> m_counters; // 每个工作线程一组计数
+    IdleTracker m_idle; // 已接受与已结束的任务数，供 WaitIdle 判断静止
+    TimerWheel m_timer; // 到期的延迟任务通过 TryAddTask 进入队列
 
     void Start(int threadnum);
     void RunInThread(size_t index);
     void Stop();
+    // AddTask 去掉运行检查与静止计数后的入队部分
+    SubmitStatus Enqueue(Task&& task);
+    // 到期任务只做非阻塞提交，队列满时返回 false 由时间轮下一个 tick 重试，定时线程上不执行用户任务；
+    // 线程池已停止时丢弃
+    bool DispatchTimerTask(Task& task)
+    {
+        return TryAddTask(std::move(task)) || !m_running.load();
+    }
 
 public:
-    explicit WorkStealingThreadPool(int threadnum = std::thread::hardware_concurrency());
+    // placement 为 Compact 时按 CPU 拓扑绑定工作线程，并让窃取优先选择共享缓存、同一 NUMA 节点的线程
+    // stealHalf 为 true 时一次窃取受害者约一半的任务（上限 32 个）放入自己的本地队列
+    explicit WorkStealingThreadPool(int threadnum = std::thread::hardware_concurrency(),
+                                    WorkerPlacement placement = WorkerPlacement::None,
+                                    bool stealHalf = true);
     ~WorkStealingThreadPool();
 
     void StopThreadPool();
 
-    void AddTask(Task&& task);
-    void AddTask(const Task& task);
+    // 不停止工作线程的统计快照，queueHighWatermark 为各线程自己桶的历史最大长度
+    ThreadPoolStats GetStats() const;
+
+    // 当前线程是否为本线程池的工作线程
+    bool InWorkerThread() const;
+
+    // 工作线程内提交的任务进入该线程自己的本地队列（队列满时在当前线程直接执行，不受背压策略影响），
+    // 外部线程按各自的提交分片（见 SubmitShard）选择桶，桶的锁被占用时试下一个桶，桶满时按背压策略处理。返回 Rejected / TimedOut / Stopped 时任务没有执行
+    SubmitStatus AddTask(Task&& task);
+
+    // 外部线程提交时桶满的处理方式；timeout 只对 BlockWithTimeout 有效。批量提交遇到 CallerRuns 时按 Reject 处理
+    void SetBackpressure(BackpressurePolicy policy, std::chrono::milliseconds timeout = std::chrono::seconds(1))
+    {
+        m_taskQueue.GetBackpressure().Set(policy, timeout);
+    }
+
+    // 不阻塞地提交任务，队列已满或线程池已停止时返回 false 且不移动 task
+    bool TryAddTask(Task&& task);
+
+    // 在调用线程上执行一个待处理任务，没有可执行的任务时返回 false
+    // 等待子任务的线程借此参与计算而不是阻塞
+    bool RunPendingTask();
+
+    // 是否值得再拆分出新任务：有空闲（自旋或睡眠）的工作线程，或当前工作线程的本地队列已空
+    bool WantsWork() const;
+
+    size_t ThreadNum() const { return m_threadnum; }
+
+    // 线程池是否仍在运行
+    bool IsRunning() const { return m_running.load(); }
+
+    // 阻塞直到所有已接受的任务（排队中与执行中，包括它们派生的子任务）都已结束，或线程池已停止
+    // 尚未到期的定时任务不计在内；不能在本线程池的工作线程内调用
+    void WaitIdle()
+    {
+        m_idle.WaitIdle(std::chrono::steady_clock::time_point::max());
+    }
+    // 与 WaitIdle 相同，timeout 内仍未静止时返回 false
+    template<typename Rep, typename Period>
+    bool WaitIdleFor(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        return m_idle.WaitIdle(std::chrono::steady_clock::now()
+                               + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout));
+    }
+
+    // co_await pool.Schedule() 把协程切换到本线程池的工作线程上继续执行（C++20 协程，见 CoTask.h）
+    ScheduleAwaiter<WorkStealingThreadPool> Schedule() { return ScheduleAwaiter<WorkStealingThreadPool>(*this); }
+
+    // 延迟与周期任务：由一个定时线程在到期时放入任务队列，等待期间不占用工作线程
+    // 返回的句柄可传给 CancelTimer，线程池停止后返回 InvalidTimerId
+    TimerId ScheduleAfter(TimerWheel::Clock::duration delay, Task task)
+    {
+        return m_timer.ScheduleAfter(delay, std::move(task));
+    }
+    TimerId ScheduleAt(TimerWheel::Clock::time_point when, Task task)
+    {
+        return m_timer.ScheduleAt(when, std::move(task));
+    }
+    // 每隔 period 执行一次，上一次还未执行完时跳过本次
+    TimerId ScheduleEvery(TimerWheel::Clock::duration period, Task task)
+    {
+        return m_timer.ScheduleEvery(period, std::move(task));
+    }
+    // 取消尚未到期的定时器，成功时返回 true
+    bool CancelTimer(TimerId id)
+    {
+        return m_timer.Cancel(id);
+    }
 
     template<typename T, typename... Args>
     auto AddTaskWithReturn(T&& task, Args&&... args) -> std::future<decltype(task(args...))>
@@ -45,18 +138,110 @@ public:
             return std::future<ReturnType>();
         }
 
-        auto packaged_task = std::make_shared<std::packaged_task<ReturnType()>>(
-            std::bind(std::forward<T>(task), std::forward<Args>(args)...)
-        );
+        auto packaged = PackageTask<Task>(std::forward<T>(task), std::forward<Args>(args)...);
+
+        // 被背压策略拒绝时同样返回无效的 future
+        if (!Accepted(AddTask(std::move(packaged.first))))
+        {
+            return std::future<ReturnType>();
+        }
+        return std::move(packaged.second);
+    }
+
+    // 带取消令牌或截止时间提交：任务出队后、执行前检查 guard，已取消或已过期时不执行，计入 cancelledTasks
+    // 同一个 CancellationSource 的令牌可以分给一整批任务，Cancel() 一次使整批在出队时被丢弃
+    template<typename F>
+    SubmitStatus AddTask(TaskGuard guard, F&& func)
+    {
+        return AddTask(MakeGuardedTask<Task>(std::move(guard), &m_cancelledTasks, std::forward<F>(func)));
+    }
+
+    // 被丢弃的任务不执行，future 得到 TaskCancelled 异常；线程池未运行或被背压策略拒绝时返回无效的 future
+    template<typename T, typename... Args>
+    auto AddTaskWithReturn(TaskGuard guard, T&& task, Args&&... args) -> std::future<decltype(task(args...))>
+    {
+        using ReturnType = decltype(task(args...));
+
+        if (!m_running.load())
+        {
+            return std::future<ReturnType>();
+        }
+
+        auto packaged = PackageGuardedTask<Task>(std::move(guard), &m_cancelledTasks,
+                                                 std::forward<T>(task), std::forward<Args>(args)...);
+        if (!Accepted(AddTask(std::move(packaged.first))))
+        {
+            return std::future<ReturnType>();
+        }
+        return std::move(packaged.second);
+    }
 
-        std::future<ReturnType> result = packaged_task->get_future();
+    // 与 AddTaskWithReturn 相同，但返回可挂接后续任务的 Future：Then 的后续任务默认在本线程池上执行，
+    // 等待结果的一方不必阻塞工作线程。线程池已停止或任务被背压策略拒绝时返回的 Future 带 broken_promise 异常
+    template<typename T, typename... Args>
+    auto AddTaskWithFuture(T&& task, Args&&... args)
+    {
+        auto packaged = PackageFutureTask<Task>(Executor(*this), std::forward<T>(task), std::forward<Args>(args)...);
+        AddTask(std::move(packaged.first));
+        return std::move(packaged.second);
+    }
+
+    // 批量提交：外部线程一次性把区间均匀切分到各个桶，每个桶只加锁一次；
+    // 工作线程内调用时全部进入自己的本地队列。返回实际提交的任务数
+    template<typename ForwardIt>
+    size_t AddTasks(ForwardIt first, ForwardIt last)
+    {
+        static_assert(IsForwardIterator<ForwardIt>, "AddTasks requires forward iterators; use AddTasksWithReturn for single-pass ranges");
+        if (!m_running.load()) return 0;
 
-        Task wrapper_task = [packaged_task]()
+        size_t added = 0;
+        if (InWorkerThread())
         {
-            (*packaged_task)();
-        };
+            for (; first != last; ++first, ++added)
+            {
+                AddTask(Task(*first));
+            }
+            return added;
+        }
+
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        m_idle.Submitted(count);
+        size_t start = SubmitShard(m_threadnum);
+        for (size_t i = 0; i < m_threadnum && first != last; ++i)
+        {
+            size_t chunk = count / m_threadnum + (i < count % m_threadnum ? 1 : 0);
+            ForwardIt chunkEnd = std::next(first, chunk);
+            added += m_taskQueue.AddTasks(first, chunkEnd, (start + i) % m_threadnum);
+            first = chunkEnd;
+        }
+        if (added < count) m_idle.Completed(count - added);
+        return added;
+    }
+
+    // 批量提交带返回值的任务，返回与输入顺序一致的 future 列表；区间只遍历一次，可以是单遍输入迭代器
+    template<typename InputIt>
+    auto AddTasksWithReturn(InputIt first, InputIt last)
+    {
+        using Func = typename std::iterator_traits<InputIt>::value_type;
+        using ReturnType = std::invoke_result_t<Func&>;
+
+        std::vector<std::future<ReturnType>> results;
+        if (!m_running.load()) return results;
 
-        AddTask(std::move(wrapper_task));
-        return result;
+        std::vector<Task> tasks;
+        // 单遍输入迭代器不能先计数，边遍历边放入
+        if constexpr (IsForwardIterator<InputIt>)
+        {
+            tasks.reserve(std::distance(first, last));
+            results.reserve(tasks.capacity());
+        }
+        for (; first != last; ++first)
+        {
+            auto packaged = PackageTask<Task>(*first);
+            tasks.emplace_back(std::move(packaged.first));
+            results.emplace_back(std::move(packaged.second));
+        }
+        AddTasks(std::make_move_iterator(tasks.begin()), std::make_move_iterator(tasks.end()));
+        return results;
     }
-};
\ No newline at end of file
+};
@@ -1,46 +1,141 @@
 #include "../include/CacheThreadPool.h"
+
+namespace
+{
+// 当前线程所属的线程池，外部线程为 nullptr
+thread_local const CacheThreadPool* t_currentPool = nullptr;
+// 工作线程占用的槽位，用于在 RunPendingTask 中累计自己的计数
+thread_local size_t t_workerSlot = 0;
+}
+
 void CacheThreadPool::Start(int threadnum)
 {
     m_running = true;
-    m_currentThreadnum = threadnum;
-    m_threadgroup.reserve(threadnum);
+    std::lock_guard<std::mutex> lock(m_mutex);
     for(int i = 0; i < threadnum; ++i)
     {
-      auto thread = std::thread(&CacheThreadPool::RunInThread,this);
-      std::thread::id threadId = thread.get_id();
-      m_threadgroup.emplace(threadId,std::move(thread));
-      m_idelThreadnum++;
+        ActivateWorker();
+    }
+}
+// 持有 m_mutex 时调用：优先用一次唤醒重新激活待命线程，没有待命线程时在空闲槽位上新建线程
+// 槽位全部被占用时返回 false
+bool CacheThreadPool::ActivateWorker()
+{
+    for(size_t i = 0; i < m_slotCount; ++i)
+    {
+        WorkerSlot& worker = m_workers[i];
+        if(worker.state.load() != WorkerState::Standby) continue;
+        // 先更新计数再改状态，被唤醒的线程取到任务时空闲计数已经包含它
+        m_standbyThreadnum--;
+        m_currentThreadnum++;
+        m_idelThreadnum++;
+        worker.state.store(WorkerState::Active, std::memory_order_release);
+        worker.wake.NotifyAll();
+        return true;
+    }
+    for(size_t i = 0; i < m_slotCount; ++i)
+    {
+        WorkerSlot& worker = m_workers[i];
+        if(worker.state.load() != WorkerState::Free) continue;
+        // 上一个线程把槽位置为 Free 后就已返回，这里的 join 不会长时间等待
+        if(worker.thread.joinable()) worker.thread.join();
+        m_currentThreadnum++;
+        m_idelThreadnum++;
+        worker.state.store(WorkerState::Active, std::memory_order_release);
+        worker.thread = std::thread(&CacheThreadPool::RunInThread, this, i);
+        return true;
+    }
+    return false;
+}
+void CacheThreadPool::MaybeGrow()
+{
+    // 常见情况只读几个原子计数就返回：已到上限、还有空闲线程或队列为空
+    if(m_currentThreadnum.load() >= m_maxThreadnum || m_idelThreadnum.load() > 0) return;
+    size_t queued = m_taskqueue.Size();
+    if(queued == 0) return;
+
+    uint64_t now = WorkerCounters::NowNs();
+    bool backlogged = queued >= m_growBacklog.load(std::memory_order_relaxed);
+    // 时间戳可能由其他线程在本线程读取 now 之后写入，比较时不做减法以免无符号回绕
+    bool stalled = now >= m_lastTakeNs.load(std::memory_order_relaxed) + m_growDelayNs.load(std::memory_order_relaxed);
+    if(!backlogged && !stalled) return;
+
+    // 限速：同一间隔内只有抢到时间戳的一个提交者扩容
+    uint64_t last = m_lastSpawnNs.load(std::memory_order_relaxed);
+    if(last != 0 && now < last + m_spawnIntervalNs.load(std::memory_order_relaxed)) return;
+    if(!m_lastSpawnNs.compare_exchange_strong(last, now, std::memory_order_relaxed)) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_running.load() || m_currentThreadnum.load() >= m_maxThreadnum) return;
+    ActivateWorker();
+}
+// 空闲超时后调用。返回 true 表示线程继续工作（未超出核心线程数，或待命后被重新激活），false 表示线程应退出
+// 活动线程与待命线程之间形成滞回区间：负载在区间内来回波动时只有停靠与唤醒，不创建也不销毁线程
+bool CacheThreadPool::Retire(size_t slot)
+{
+    WorkerSlot& worker = m_workers[slot];
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_running.load()) return false;
+        if(m_currentThreadnum.load() <= m_coreThreadnum) return true;
+        m_currentThreadnum--;
+        m_idelThreadnum--;
+        if(m_standbyThreadnum.load() >= m_maxStandby.load())
+        {
+            worker.state.store(WorkerState::Free, std::memory_order_release);
+            return false;
+        }
+        m_standbyThreadnum++;
+        worker.state.store(WorkerState::Standby, std::memory_order_release);
+    }
+
+    // 停靠直到被重新激活（Active）、被 SetStandbyThreads 释放（Free）或线程池停止
+    while(true)
+    {
+        auto key = worker.wake.PrepareWait();
+        if(worker.state.load(std::memory_order_acquire) != WorkerState::Standby || !m_running.load())
+        {
+            worker.wake.CancelWait();
+            break;
+        }
+        worker.wake.Wait(key);
     }
+    return worker.state.load(std::memory_order_acquire) == WorkerState::Active;
 }
-void CacheThreadPool::RunInThread()
+void CacheThreadPool::RunInThread(size_t slot)
 {
-    auto tid = std::this_thread::get_id();
+    t_currentPool = this;
+    t_workerSlot = slot;
+    WorkerCounters& counters = m_counters[slot];
+
+    // 每次从共享队列取出一小批任务放在自己的批次里逐个执行，摊薄队列同步开销；
+    // 批次中尚未开始的任务其他空闲线程随时可以取走
+    Task task;
+    uint64_t last = WorkerCounters::NowNs();
     while(m_running.load())
     {
-       Task task;
-       auto status = m_taskqueue.TakeTask(task);
+       auto status = m_taskqueue.TakeTask(task, slot, m_currentThreadnum.load());
+       uint64_t taken = WorkerCounters::NowNs();
+       WorkerCounters::Add(counters.idleNs, taken - last);
+       last = taken;
        if(status == QueueStatus::OK)
        {
+        m_lastTakeNs.store(taken, std::memory_order_relaxed);
         m_idelThreadnum--;
+        // 一批突发任务可能在新线程启动前就已全部提交，取到任务的线程继续检查积压，扩容才能逐步跟上
+        MaybeGrow();
         task();
+        task = nullptr;
+        m_idle.Completed();
         m_idelThreadnum++;
+        last = WorkerCounters::NowNs();
+        WorkerCounters::Add(counters.busyNs, last - taken);
+        WorkerCounters::Add(counters.executed, 1);
        }
        else if(status == QueueStatus::TIMEOUT)
        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            if(m_currentThreadnum > m_coreThreadnum)
-            {
-                auto it = m_threadgroup.find(tid);
-                if(it != m_threadgroup.end())
-                {
-                    if(it->second.joinable())
-                    it->second.detach();
-                    m_threadgroup.erase(it);
-                }
-                m_currentThreadnum--;
-                m_idelThreadnum--;
-                return;
-            }
+            if(!Retire(slot)) return;
+            last = WorkerCounters::NowNs(); // 待命时间不计入空闲时间
        }
        else if(status == QueueStatus::STOPPED)
        {
@@ -48,31 +143,104 @@ void CacheThreadPool::RunInThread()
        }
     }
 }
+void CacheThreadPool::SetStandbyThreads(int count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxStandby.store(std::max(count, 0));
+    for(size_t i = 0; i < m_slotCount && m_standbyThreadnum.load() > m_maxStandby.load(); ++i)
+    {
+        WorkerSlot& worker = m_workers[i];
+        if(worker.state.load() != WorkerState::Standby) continue;
+        m_standbyThreadnum--;
+        worker.state.store(WorkerState::Free, std::memory_order_release);
+        worker.wake.NotifyAll();
+    }
+}
 void CacheThreadPool::Stop()
 {
     if(!m_running.load()){return;}
     
-    m_running = false;
+    m_timer.Stop(); // 先停定时线程，它可能正在向队列派发到期任务
+    // 在锁内置停止标志，之后不会再有线程被激活或新建，槽位中的线程对象不再变化
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
     m_taskqueue.Stop(false);  // 停止队列，但不丢弃未处理任务
+    m_idle.Close();           // 剩余任务不再执行，WaitIdle 的等待者直接返回
+    for(size_t i = 0; i < m_slotCount; ++i)
+    {
+        m_workers[i].wake.NotifyAll(); // 唤醒待命线程退出
+    }
     
     // 等待所有线程结束
-    for(auto& thread : m_threadgroup)
+    for(size_t i = 0; i < m_slotCount; ++i)
     {
-        if(thread.second.joinable())
+        if(m_workers[i].thread.joinable())
         {
-            thread.second.join();
+            m_workers[i].thread.join();
         }
     }
-    m_threadgroup.clear();
 }
 
-void CacheThreadPool::AddTask(Task&& task)
+ThreadPoolStats CacheThreadPool::GetStats() const
 {
-    if(!m_running.load()) return;
-    m_taskqueue.AddTask(std::forward<Task>(task));
+    ThreadPoolStats stats;
+    stats.workers.resize(m_slotCount);
+    for(size_t i = 0; i < m_slotCount; ++i)
+    {
+        stats.workers[i].Load(m_counters[i]);
+        stats.total += stats.workers[i];
+    }
+    stats.threadCount = static_cast<size_t>(std::max(m_currentThreadnum.load(), 0));
+    stats.idleThreads = static_cast<size_t>(std::max(m_idelThreadnum.load(), 0));
+    stats.standbyThreads = static_cast<size_t>(std::max(m_standbyThreadnum.load(), 0));
+    stats.queueSize = m_taskqueue.Size();
+    stats.queueHighWatermark = m_taskqueue.HighWatermark();
+    stats.rejectedTasks = m_taskqueue.GetBackpressure().Rejected();
+    stats.droppedTasks = m_taskqueue.GetBackpressure().Dropped();
+    stats.cancelledTasks = m_cancelledTasks.load(std::memory_order_relaxed);
+    return stats;
 }
-void CacheThreadPool::AddTask(const Task& task)
+
+bool CacheThreadPool::InWorkerThread() const
 {
-    if(!m_running.load()) return;
-    m_taskqueue.AddTask(task);
-}
\ No newline at end of file
+    return t_currentPool == this;
+}
+
+bool CacheThreadPool::RunPendingTask()
+{
+    Task task;
+    if(!m_taskqueue.TryTakeTask(task)) return false;
+    task();
+    m_idle.Completed();
+    // 工作线程在此执行的任务计入自己的 executed，耗时已包含在外层任务的 busyNs 中
+    if(InWorkerThread()) WorkerCounters::Add(m_counters[t_workerSlot].executed, 1);
+    return true;
+}
+
+bool CacheThreadPool::TryAddTask(Task&& task)
+{
+    if(!m_running.load()) return false;
+    m_idle.Submitted();
+    bool added = m_taskqueue.TryAddTask(std::move(task)) == QueueStatus::OK;
+    MaybeGrow();
+    if(!added) m_idle.Completed();
+    return added;
+}
+
+SubmitStatus CacheThreadPool::AddTask(Task&& task)
+{
+    return AddTask(TaskPriority::Normal, std::forward<Task>(task));
+}
+
+SubmitStatus CacheThreadPool::AddTask(TaskPriority priority, Task&& task)
+{
+    if(!m_running.load()) return SubmitStatus::Stopped;
+    m_idle.Submitted(); // 先计入再入队，工作线程不会在计入之前完成它
+    QueueStatus status = m_taskqueue.AddTask(std::forward<Task>(task), priority);
+    MaybeGrow();
+    SubmitStatus result = m_taskqueue.GetBackpressure().Complete(status, task);
+    if(result != SubmitStatus::Queued) m_idle.Completed();
+    return result;
+}
@@ -0,0 +1,200 @@
+#include "../include/CpuTopology.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <tuple>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+const char* const CpuRoot = "/sys/devices/system/cpu/";
+const char* const NodeRoot = "/sys/devices/system/node/";
+
+bool ReadFile(const std::string& path, std::string& text)
+{
+    std::ifstream in(path);
+    if (!in) return false;
+    std::getline(in, text);
+    return true;
+}
+
+bool ReadInt(const std::string& path, int& value)
+{
+    std::string text;
+    if (!ReadFile(path, text)) return false;
+    try
+    {
+        value = std::stoi(text);
+    }
+    catch (...)
+    {
+        return false;
+    }
+    return true;
+}
+
+// 末级缓存编号：遍历 cache/indexN，取级别最高的缓存的共享 CPU 中最小者
+int DetectLlc(int cpu)
+{
+    int bestLevel = -1;
+    int llc = cpu;
+    for (int index = 0;; ++index)
+    {
+        std::string dir = std::string(CpuRoot) + "cpu" + std::to_string(cpu) + "/cache/index" + std::to_string(index) + "/";
+        int level = 0;
+        if (!ReadInt(dir + "level", level)) break;
+        std::string shared;
+        if (level > bestLevel && ReadFile(dir + "shared_cpu_list", shared))
+        {
+            auto cpus = CpuTopology::ParseCpuList(shared);
+            if (!cpus.empty())
+            {
+                bestLevel = level;
+                llc = *std::min_element(cpus.begin(), cpus.end());
+            }
+        }
+    }
+    return llc;
+}
+}
+
+std::vector<int> CpuTopology::ParseCpuList(const std::string& text)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        if (item.empty()) continue;
+        try
+        {
+            auto dash = item.find('-');
+            int first = std::stoi(item.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        catch (...)
+        {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+CpuTopology CpuTopology::Detect()
+{
+    CpuTopology topology;
+    std::string online;
+    std::vector<int> cpus;
+    if (ReadFile(std::string(CpuRoot) + "online", online)) cpus = ParseCpuList(online);
+#if defined(__linux__)
+    // 只保留当前进程允许运行的 CPU（taskset / cgroup 限制）
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                                  [&allowed](int cpu){ return cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed); }),
+                   cpus.end());
+    }
+#endif
+    if (cpus.empty())
+    {
+        unsigned hc = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < hc; ++i) cpus.push_back(static_cast<int>(i));
+    }
+
+    // NUMA 节点：node 目录中的编号可能不连续，按 CPU 数量上限探测
+    std::map<int, int> nodeOf;
+    for (int node = 0; node < static_cast<int>(cpus.size()) + 64; ++node)
+    {
+        std::string list;
+        if (!ReadFile(std::string(NodeRoot) + "node" + std::to_string(node) + "/cpulist", list)) continue;
+        for (int cpu : ParseCpuList(list)) nodeOf[cpu] = node;
+    }
+
+    std::map<std::pair<int, int>, int> smtCount; // (package, core) -> 已分配的超线程数
+    for (int cpu : cpus)
+    {
+        CpuInfo info;
+        info.cpu = cpu;
+        std::string topo = std::string(CpuRoot) + "cpu" + std::to_string(cpu) + "/topology/";
+        if (!ReadInt(topo + "core_id", info.core)) info.core = cpu;
+        if (!ReadInt(topo + "physical_package_id", info.package)) info.package = 0;
+        info.llc = DetectLlc(cpu);
+        auto node = nodeOf.find(cpu);
+        info.node = node == nodeOf.end() ? info.package : node->second;
+        info.smt = smtCount[{info.package, info.core}]++;
+        topology.m_cpus.push_back(info);
+    }
+    return topology;
+}
+
+const CpuInfo* CpuTopology::Find(int cpu) const
+{
+    auto it = std::lower_bound(m_cpus.begin(), m_cpus.end(), cpu,
+                               [](const CpuInfo& info, int value){ return info.cpu < value; });
+    if (it == m_cpus.end() || it->cpu != cpu) return nullptr;
+    return &*it;
+}
+
+std::vector<int> CpuTopology::PlacementOrder() const
+{
+    std::vector<CpuInfo> sorted = m_cpus;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const CpuInfo& a, const CpuInfo& b)
+    {
+        return std::tie(a.node, a.llc, a.smt, a.package, a.core) < std::tie(b.node, b.llc, b.smt, b.package, b.core);
+    });
+    std::vector<int> order;
+    order.reserve(sorted.size());
+    for (const auto& info : sorted) order.push_back(info.cpu);
+    return order;
+}
+
+int CpuTopology::Distance(int cpuA, int cpuB) const
+{
+    const CpuInfo* a = Find(cpuA);
+    const CpuInfo* b = Find(cpuB);
+    if (!a || !b) return 3;
+    if (a->package == b->package && a->core == b->core) return 0;
+    if (a->llc == b->llc) return 1;
+    if (a->node == b->node) return 2;
+    return 3;
+}
+
+bool PinCurrentThread(int cpu)
+{
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+std::vector<std::vector<size_t>> BuildStealOrder(const CpuTopology& topology, const std::vector<int>& workerCpus)
+{
+    size_t count = workerCpus.size();
+    std::vector<std::vector<size_t>> order(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto& victims = order[i];
+        for (size_t step = 1; step < count; ++step) victims.push_back((i + step) % count);
+        std::stable_sort(victims.begin(), victims.end(), [&](size_t a, size_t b)
+        {
+            return topology.Distance(workerCpus[i], workerCpus[a]) < topology.Distance(workerCpus[i], workerCpus[b]);
+        });
+    }
+    return order;
+}
@@ -1,28 +1,63 @@
 #include "../include/FixedThreadPool.h"
 
-void FixedThreadPool::Start(int threadnum)
+namespace
+{
+// 当前线程所属的线程池，外部线程为 nullptr
+thread_local const FixedThreadPool* t_currentPool = nullptr;
+// 工作线程的编号，用于在 RunPendingTask 中累计自己的计数
+thread_local size_t t_workerIndex = 0;
+}
+
+void FixedThreadPool::Start(int threadnum, WorkerPlacement placement)
 {
     m_running = true;
-    m_threadgroup.reserve(threadnum);
+    m_threadnum = threadnum > 0 ? static_cast<size_t>(threadnum) : 1;
+    m_threadgroup.reserve(m_threadnum);
+    m_counters = std::make_unique<WorkerCounters[]>(m_threadnum);
+    m_taskqueue.SetConsumerCount(m_threadnum);
+    if(placement == WorkerPlacement::Compact)
+    {
+        std::vector<int> order = CpuTopology::Detect().PlacementOrder();
+        m_workerCpus.resize(m_threadnum);
+        for(size_t i = 0; i < m_threadnum; ++i)
+        {
+            m_workerCpus[i] = order[i % order.size()];
+        }
+    }
     
-    for(int i = 0; i < threadnum; ++i)
+    for(size_t i = 0; i < m_threadnum; ++i)
     {
-        m_threadgroup.emplace_back(&FixedThreadPool::RunInThread, this);
+        m_threadgroup.emplace_back(&FixedThreadPool::RunInThread, this, i);
     }
 }
 
-void FixedThreadPool::RunInThread()
+void FixedThreadPool::RunInThread(size_t index)
 {
+    t_currentPool = this;
+    t_workerIndex = index;
+    if(!m_workerCpus.empty())
+    {
+        PinCurrentThread(m_workerCpus[index]);
+    }
+    WorkerCounters& counters = m_counters[index];
+    // 每次从共享队列取出一小批任务放在自己的批次里逐个执行，摊薄队列同步开销；
+    // 批次中尚未开始的任务其他空闲线程随时可以取走
+    Task task;
+    uint64_t last = WorkerCounters::NowNs();
     while(m_running.load())
     {
-        Task task;
-        m_taskqueue.TakeTask(task);
-        
-        // 如果线程池已停止，退出循环
-        if(!m_running.load()){ break;}  
+        bool got = m_taskqueue.TakeTask(task, index, m_threadnum);
+        uint64_t taken = WorkerCounters::NowNs();
+        WorkerCounters::Add(counters.idleNs, taken - last);
+        if(!got){ break;} // 队列已停止
         
-        // 执行任务
+        // 执行已经取出的任务，即使线程池正在停止也不丢弃
         if(task){task();}
+        task = nullptr;
+        m_idle.Completed();
+        last = WorkerCounters::NowNs();
+        WorkerCounters::Add(counters.busyNs, last - taken);
+        WorkerCounters::Add(counters.executed, 1);
     }
 }
 
@@ -30,8 +65,10 @@ void FixedThreadPool::Stop()
 {
     if(!m_running.load()){return;}
     
+    m_timer.Stop(); // 先停定时线程，它可能正在向队列派发到期任务
     m_running = false;
     m_taskqueue.Stop(false);  // 停止队列，但不丢弃未处理任务
+    m_idle.Close();           // 剩余任务不再执行，WaitIdle 的等待者直接返回
     
     // 等待所有线程结束
     for(auto& thread : m_threadgroup)
@@ -49,19 +86,65 @@ void FixedThreadPool::StopThreadPool()
     std::call_once(m_flag, [this]{Stop();});
 }
 
-void FixedThreadPool::AddTask(Task&& task)
+ThreadPoolStats FixedThreadPool::GetStats() const
 {
-    if(m_running.load())
+    ThreadPoolStats stats;
+    stats.workers.resize(m_threadnum);
+    for(size_t i = 0; i < m_threadnum; ++i)
     {
-        m_taskqueue.AddTask(std::forward<Task>(task));
+        stats.workers[i].Load(m_counters[i]);
+        stats.total += stats.workers[i];
     }
+    stats.threadCount = m_threadnum;
+    stats.idleThreads = m_taskqueue.Spinning() + m_taskqueue.Sleeping();
+    stats.queueSize = m_taskqueue.Size();
+    stats.queueHighWatermark = m_taskqueue.HighWatermark();
+    stats.rejectedTasks = m_taskqueue.GetBackpressure().Rejected();
+    stats.droppedTasks = m_taskqueue.GetBackpressure().Dropped();
+    stats.cancelledTasks = m_cancelledTasks.load(std::memory_order_relaxed);
+    return stats;
 }
 
-void FixedThreadPool::AddTask(const Task& task)
+bool FixedThreadPool::InWorkerThread() const
 {
-    if(m_running.load())
-    {
-        m_taskqueue.AddTask(task);
-    }
+    return t_currentPool == this;
 }
 
+bool FixedThreadPool::RunPendingTask()
+{
+    // 与工作线程一致，停止后剩余的任务不再执行
+    if(!m_running.load()) return false;
+    Task task;
+    if(!m_taskqueue.TryTakeTask(task)) return false;
+    task();
+    m_idle.Completed();
+    // 工作线程在此执行的任务计入自己的 executed，耗时已包含在外层任务的 busyNs 中
+    if(InWorkerThread()) WorkerCounters::Add(m_counters[t_workerIndex].executed, 1);
+    return true;
+}
+
+bool FixedThreadPool::TryAddTask(Task&& task)
+{
+    if(!m_running.load()) return false;
+    m_idle.Submitted();
+    bool added = m_taskqueue.TryAddTask(std::move(task)) == QueueStatus::OK;
+    if(!added) m_idle.Completed();
+    return added;
+}
+
+SubmitStatus FixedThreadPool::AddTask(Task&& task)
+{
+    return AddTask(TaskPriority::Normal, std::forward<Task>(task));
+}
+
+SubmitStatus FixedThreadPool::AddTask(TaskPriority priority, Task&& task)
+{
+    if(!m_running.load()) return SubmitStatus::Stopped;
+    m_idle.Submitted(); // 先计入再入队，工作线程不会在计入之前完成它
+    QueueStatus status = m_taskqueue.AddTask(std::forward<Task>(task), priority);
+    SubmitStatus result = m_taskqueue.GetBackpressure().Complete(status, task);
+    if(result != SubmitStatus::Queued) m_idle.Completed();
+    return result;
+}
+
+
@@ -0,0 +1,153 @@
+#include "../include/TaskGraph.h"
+
+#include <stdexcept>
+#include <utility>
+
+TaskGraph::NodeId TaskGraph::AddNode(Task work)
+{
+    if (m_running.load(std::memory_order_acquire)) throw std::logic_error("TaskGraph modified while running");
+    m_work.push_back(std::move(work));
+    m_successors.emplace_back();
+    m_predecessors.push_back(0);
+    m_validated = false;
+    return m_work.size() - 1;
+}
+
+void TaskGraph::AddEdge(NodeId from, NodeId to)
+{
+    if (m_running.load(std::memory_order_acquire)) throw std::logic_error("TaskGraph modified while running");
+    if (from >= m_work.size() || to >= m_work.size() || from == to)
+    {
+        throw std::invalid_argument("TaskGraph::AddEdge: invalid node id");
+    }
+    m_successors[from].push_back(to);
+    ++m_predecessors[to];
+    m_validated = false;
+}
+
+// 图变化后的第一次运行前做一次拓扑排序检查环，并记下根节点；之后的运行直接复用
+void TaskGraph::Validate()
+{
+    if (m_validated) return;
+
+    size_t count = m_work.size();
+    std::vector<uint32_t> indegree = m_predecessors;
+    std::vector<NodeId> order;
+    order.reserve(count);
+    for (NodeId node = 0; node < count; ++node)
+    {
+        if (indegree[node] == 0) order.push_back(node);
+    }
+    size_t rootCount = order.size();
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        for (NodeId next : m_successors[order[i]])
+        {
+            if (--indegree[next] == 0) order.push_back(next);
+        }
+    }
+    if (order.size() != count) throw std::logic_error("TaskGraph contains a cycle");
+
+    m_roots.assign(order.begin(), order.begin() + rootCount);
+    if (m_joinCount != count)
+    {
+        m_joins = std::make_unique<std::atomic<uint32_t>[]>(count);
+        m_joinCount = count;
+    }
+    m_validated = true;
+}
+
+void TaskGraph::RunNode(NodeId node)
+{
+    if (!m_failed.load(std::memory_order_relaxed))
+    {
+        try
+        {
+            m_work[node]();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_errorMutex);
+            if (!m_error) m_error = std::current_exception();
+            m_failed.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // acq_rel 让最后一个前驱之前的所有写入对后继可见；后继由当前工作线程放入自己的本地队列
+    // 在外部线程上（根节点被背压策略拒绝而就地执行时）提交被拒绝的后继同样就地执行，保证整张图总能完成
+    for (NodeId next : m_successors[node])
+    {
+        if (m_joins[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            Task task([this, next]{ RunNode(next); });
+            if (!Accepted(m_pool->AddTask(std::move(task)))) task();
+        }
+    }
+    if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) Finish();
+}
+
+void TaskGraph::Finish()
+{
+    // 先取出结果再结束运行，Future 的后续任务可以立即开始下一次运行
+    std::unique_ptr<Promise<void>> promise = std::move(m_promise);
+    std::exception_ptr error = std::exchange(m_error, nullptr);
+    std::shared_ptr<EventCount> finished = m_finished;
+    m_running.store(false, std::memory_order_release);
+    if (error) promise->SetException(error);
+    else promise->SetValue();
+    finished->NotifyAll();
+}
+
+Future<void> TaskGraph::RunAsync(WorkStealingThreadPool& pool)
+{
+    bool expected = false;
+    if (!m_running.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+    {
+        throw std::logic_error("TaskGraph is already running");
+    }
+    try
+    {
+        Validate();
+    }
+    catch (...)
+    {
+        m_running.store(false, std::memory_order_release);
+        throw;
+    }
+
+    auto promise = std::make_unique<Promise<void>>(Executor(pool));
+    Future<void> result = promise->GetFuture();
+    if (m_work.empty() || !pool.IsRunning())
+    {
+        if (m_work.empty()) promise->SetValue();
+        m_running.store(false, std::memory_order_release);
+        return result; // 线程池已停止时 promise 未写入就销毁，Future 得到 broken_promise
+    }
+
+    for (size_t node = 0; node < m_work.size(); ++node)
+    {
+        m_joins[node].store(m_predecessors[node], std::memory_order_relaxed);
+    }
+    m_failed.store(false, std::memory_order_relaxed);
+    m_pool = &pool;
+    m_promise = std::move(promise);
+    m_remaining.store(m_work.size(), std::memory_order_release);
+
+    // 最后一个根节点提交后整张图可能立即完成并开始下一次运行，循环中不再读取可能变化的成员
+    size_t rootCount = m_roots.size();
+    const NodeId* roots = m_roots.data();
+    for (size_t i = 0; i < rootCount; ++i)
+    {
+        Task task([this, root = roots[i]]{ RunNode(root); });
+        if (!Accepted(pool.AddTask(std::move(task)))) task();
+    }
+    return result;
+}
+
+void TaskGraph::Run(WorkStealingThreadPool& pool)
+{
+    // 等待期间帮忙执行池中的任务，没有可执行的任务时睡眠到 Finish 通知
+    Future<void> done = RunAsync(pool);
+    HelpUntil(pool, *m_finished, [&done]{ return done.Ready(); });
+    done.Get();
+}
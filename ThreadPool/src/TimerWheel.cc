@@ -0,0 +1,328 @@
+#include "../include/TimerWheel.h"
+
+#include <algorithm>
+
+namespace
+{
+// 位图中 current 之后（循环）第一个置位的槽与 current 的距离，范围 1..64，位图为空时返回 0
+unsigned NextSetDistance(uint64_t bits, uint64_t current)
+{
+    if (bits == 0) return 0;
+    unsigned shift = static_cast<unsigned>((current + 1) & 63);
+    uint64_t rotated = shift == 0 ? bits : (bits >> shift) | (bits << (64 - shift));
+    return static_cast<unsigned>(__builtin_ctzll(rotated)) + 1;
+}
+}
+
+// 派发给线程池的一次周期执行，执行完或被线程池丢弃（析构）时清除排队标记
+struct TimerWheel::PeriodicRun
+{
+    std::shared_ptr<Periodic> state;
+
+    void operator()()
+    {
+        state->task();
+    }
+    PeriodicRun(std::shared_ptr<Periodic> periodic) : state(std::move(periodic)) {}
+    PeriodicRun(PeriodicRun&&) noexcept = default;
+    ~PeriodicRun()
+    {
+        if (state) state->queued.store(false, std::memory_order_release);
+    }
+};
+
+TimerWheel::TimerWheel(Dispatcher dispatch, Clock::duration resolution)
+    : m_dispatch(std::move(dispatch)),
+      m_start(Clock::now()),
+      m_resolution(std::max(resolution, Clock::duration(1)))
+{
+    std::fill(std::begin(m_heads), std::end(m_heads), Nil);
+    std::fill(std::begin(m_occupied), std::end(m_occupied), 0);
+}
+
+TimerWheel::~TimerWheel()
+{
+    Stop();
+}
+
+uint64_t TimerWheel::ToTick(Clock::time_point when) const
+{
+    if (when <= m_start) return 0;
+    auto elapsed = when - m_start;
+    // 向上取整，定时器只会晚于而不会早于指定时刻触发
+    return static_cast<uint64_t>((elapsed + m_resolution - Clock::duration(1)) / m_resolution);
+}
+
+TimerId TimerWheel::ScheduleAt(Clock::time_point when, Task&& task)
+{
+    return Insert(ToTick(when), 0, std::move(task), nullptr);
+}
+
+TimerId TimerWheel::ScheduleEvery(Clock::duration period, Task&& task)
+{
+    uint64_t periodTicks = std::max<uint64_t>(1, ToTick(m_start + period));
+    auto periodic = std::make_shared<Periodic>();
+    periodic->task = std::move(task);
+    return Insert(ToTick(Clock::now()) + periodTicks, periodTicks, Task(), std::move(periodic));
+}
+
+TimerId TimerWheel::Insert(uint64_t expires, uint64_t period, Task&& task, std::shared_ptr<Periodic> periodic)
+{
+    bool wake = false;
+    TimerId id = InvalidTimerId;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop) return InvalidTimerId;
+        if (!m_thread.joinable()) m_thread = std::thread([this]{ Run(); });
+
+        int32_t index = AllocNode();
+        Node& node = m_nodes[index];
+        node.expires = std::max(expires, m_now + 1);
+        node.period = period;
+        node.task = std::move(task);
+        node.periodic = std::move(periodic);
+        Place(index);
+        ++m_pending;
+
+        wake = node.expires < m_wakeTick;
+        id = (static_cast<uint64_t>(node.generation) << 32) | static_cast<uint64_t>(index + 1);
+    }
+    if (wake) m_cond.notify_one();
+    return id;
+}
+
+// 派发失败的任务按一次性定时器放回，在当前时间的下一个 tick 重试；调用方持有锁
+// 用当前时间而不是 m_now 计算，派发耗时较长时也不会在同一轮里反复重试
+void TimerWheel::Rearm(Task&& task)
+{
+    int32_t index = AllocNode();
+    Node& node = m_nodes[index];
+    node.expires = std::max(m_now, ToTick(Clock::now())) + 1;
+    node.period = 0;
+    node.task = std::move(task);
+    Place(index);
+    ++m_pending;
+}
+
+bool TimerWheel::Cancel(TimerId id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t slot = id & 0xffffffffu;
+    if (slot == 0 || slot > m_nodes.size()) return false;
+    int32_t index = static_cast<int32_t>(slot - 1);
+    Node& node = m_nodes[index];
+    if (node.slot == Nil || node.generation != static_cast<uint32_t>(id >> 32)) return false;
+    Unlink(index);
+    FreeNode(index);
+    --m_pending;
+    return true;
+}
+
+void TimerWheel::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop) return;
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nodes.clear();
+    m_freeNodes.clear();
+    std::fill(std::begin(m_heads), std::end(m_heads), Nil);
+    std::fill(std::begin(m_occupied), std::end(m_occupied), 0);
+    m_pending = 0;
+}
+
+size_t TimerWheel::Pending() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending;
+}
+
+int32_t TimerWheel::AllocNode()
+{
+    if (!m_freeNodes.empty())
+    {
+        int32_t index = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        return index;
+    }
+    m_nodes.emplace_back();
+    return static_cast<int32_t>(m_nodes.size() - 1);
+}
+
+void TimerWheel::FreeNode(int32_t index)
+{
+    Node& node = m_nodes[index];
+    node.task = nullptr;
+    node.periodic.reset();
+    node.slot = Nil;
+    ++node.generation; // 旧句柄从此失效
+    m_freeNodes.push_back(index);
+}
+
+// 按到期时间与 m_now 的距离放入对应层：距离小于 64^(L+1) 的放在第 L 层，槽号取到期 tick 在该层的位
+void TimerWheel::Place(int32_t index)
+{
+    Node& node = m_nodes[index];
+    uint64_t expires = std::max(node.expires, m_now);
+    uint64_t delta = std::min(expires - m_now, MaxDelta);
+    expires = m_now + delta;
+
+    unsigned level = 0;
+    while (level + 1 < LevelCount && delta >= (uint64_t(1) << (LevelBits * (level + 1)))) ++level;
+    uint64_t slot = (expires >> (LevelBits * level)) & SlotMask;
+
+    int32_t global = static_cast<int32_t>(level * SlotsPerLevel + slot);
+    node.slot = global;
+    node.prev = Nil;
+    node.next = m_heads[global];
+    if (node.next != Nil) m_nodes[node.next].prev = index;
+    m_heads[global] = index;
+    m_occupied[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::Unlink(int32_t index)
+{
+    Node& node = m_nodes[index];
+    if (node.prev != Nil) m_nodes[node.prev].next = node.next;
+    else m_heads[node.slot] = node.next;
+    if (node.next != Nil) m_nodes[node.next].prev = node.prev;
+    if (m_heads[node.slot] == Nil)
+    {
+        m_occupied[node.slot / SlotsPerLevel] &= ~(uint64_t(1) << (node.slot % SlotsPerLevel));
+    }
+    node.prev = node.next = Nil;
+}
+
+// 把第 level 层一个槽中的定时器按当前时间重新放置，它们会落到更低的层
+void TimerWheel::Cascade(unsigned level, uint64_t slot)
+{
+    int32_t global = static_cast<int32_t>(level * SlotsPerLevel + slot);
+    int32_t index = m_heads[global];
+    m_heads[global] = Nil;
+    m_occupied[level] &= ~(uint64_t(1) << slot);
+    while (index != Nil)
+    {
+        int32_t next = m_nodes[index].next;
+        Place(index);
+        index = next;
+    }
+}
+
+// 取出第 0 层当前槽中到期的定时器
+void TimerWheel::Expire(std::vector<Task>& due)
+{
+    uint64_t slot = m_now & SlotMask;
+    int32_t index = m_heads[slot];
+    m_heads[slot] = Nil;
+    m_occupied[0] &= ~(uint64_t(1) << slot);
+    while (index != Nil)
+    {
+        Node& node = m_nodes[index];
+        int32_t next = node.next;
+        if (node.expires > m_now)
+        {
+            Place(index);
+        }
+        else if (!node.periodic)
+        {
+            due.push_back(std::move(node.task));
+            FreeNode(index);
+            --m_pending;
+        }
+        else
+        {
+            // 上一次还没执行完就跳过本次，避免同一个可调用对象被并发执行或在队列中堆积
+            if (!node.periodic->queued.exchange(true, std::memory_order_acq_rel))
+            {
+                due.emplace_back(PeriodicRun(node.periodic));
+            }
+            node.expires += node.period;
+            if (node.expires <= m_now) node.expires = m_now + node.period; // 落后太多时不补发错过的周期
+            Place(index);
+        }
+        index = next;
+    }
+}
+
+void TimerWheel::Advance(uint64_t target, std::vector<Task>& due)
+{
+    while (m_now < target)
+    {
+        if (m_occupied[0] == 0)
+        {
+            // 第 0 层为空，直接跳到下一次回绕前，中间的 tick 既没有到期也不需要下放
+            uint64_t boundary = m_now | SlotMask;
+            if (boundary >= target)
+            {
+                m_now = target;
+                break;
+            }
+            m_now = boundary;
+        }
+        ++m_now;
+        for (unsigned level = 1; level < LevelCount; ++level)
+        {
+            if ((m_now & ((uint64_t(1) << (LevelBits * level)) - 1)) != 0) break;
+            Cascade(level, (m_now >> (LevelBits * level)) & SlotMask);
+        }
+        Expire(due);
+    }
+}
+
+// 下一个可能有定时器到期或需要下放的 tick，没有定时器时返回 UINT64_MAX
+uint64_t TimerWheel::NextWakeTick() const
+{
+    uint64_t next = UINT64_MAX;
+    for (unsigned level = 0; level < LevelCount; ++level)
+    {
+        unsigned shift = LevelBits * level;
+        unsigned distance = NextSetDistance(m_occupied[level], (m_now >> shift) & SlotMask);
+        if (distance == 0) continue;
+        next = std::min(next, ((m_now >> shift) + distance) << shift);
+    }
+    return next;
+}
+
+void TimerWheel::Run()
+{
+    std::vector<Task> due;
+    std::vector<Task> rejected;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop)
+    {
+        Advance(static_cast<uint64_t>((Clock::now() - m_start) / m_resolution), due);
+        if (!due.empty())
+        {
+            // 派发时不持有锁，不挡住插入与取消；线程池暂时放不下的任务放回时间轮，下一个 tick 重试
+            lock.unlock();
+            for (auto& task : due)
+            {
+                if (!m_dispatch(task)) rejected.push_back(std::move(task));
+            }
+            due.clear();
+            lock.lock();
+            if (!m_stop)
+            {
+                for (auto& task : rejected) Rearm(std::move(task));
+            }
+            rejected.clear();
+            continue;
+        }
+
+        m_wakeTick = NextWakeTick();
+        if (m_wakeTick == UINT64_MAX)
+        {
+            m_cond.wait(lock);
+        }
+        else
+        {
+            m_cond.wait_until(lock, m_start + m_resolution * m_wakeTick);
+        }
+        m_wakeTick = UINT64_MAX;
+    }
+}
@@ -13,6 +13,10 @@ inline size_t NormalizeThreadNum(int threadnum)
     }
     return static_cast<size_t>(threadnum);
 }
+
+// 当前线程所属的线程池及其桶下标，外部线程为 nullptr
+thread_local const WorkStealingThreadPool* t_currentPool = nullptr;
+thread_local size_t t_workerIndex = 0;
 }
 
 void WorkStealingThreadPool::Start(int threadnum)
@@ -20,6 +24,19 @@ void WorkStealingThreadPool::Start(int threadnum)
     m_running = true;
     m_threadnum = static_cast<size_t>(threadnum);
     m_workers.reserve(threadnum);
+    m_counters = std::make_unique<WorkerCounters[]>(m_threadnum);
+
+    if (m_placement == WorkerPlacement::Compact)
+    {
+        CpuTopology topology = CpuTopology::Detect();
+        std::vector<int> order = topology.PlacementOrder();
+        m_workerCpus.resize(m_threadnum);
+        for (size_t i = 0; i < m_threadnum; ++i)
+        {
+            m_workerCpus[i] = order[i % order.size()];
+        }
+        m_taskQueue.SetStealOrder(BuildStealOrder(topology, m_workerCpus));
+    }
 
     for (size_t i = 0; i < static_cast<size_t>(threadnum); ++i)
     {
@@ -27,12 +44,15 @@ void WorkStealingThreadPool::Start(int threadnum)
     }
 }
 
-WorkStealingThreadPool::WorkStealingThreadPool(int threadnum)
+WorkStealingThreadPool::WorkStealingThreadPool(int threadnum, WorkerPlacement placement, bool stealHalf)
     : m_taskQueue(NormalizeThreadNum(threadnum)),
       m_running(false),
-      m_roundRobin(0),
-      m_threadnum(NormalizeThreadNum(threadnum))
+      m_threadnum(NormalizeThreadNum(threadnum)),
+      m_placement(placement),
+      m_timer([this](Task& task){ return DispatchTimerTask(task); })
 {
+    m_taskQueue.SetStealHalf(stealHalf);
+    m_idle.SetDiscardCounter(&m_taskQueue.GetBackpressure().DroppedCounter());
     Start(static_cast<int>(m_threadnum));
 }
 
@@ -43,13 +63,28 @@ WorkStealingThreadPool::~WorkStealingThreadPool()
 
 void WorkStealingThreadPool::RunInThread(size_t index)
 {
+    t_currentPool = this;
+    t_workerIndex = index;
+    if (!m_workerCpus.empty())
+    {
+        PinCurrentThread(m_workerCpus[index]);
+    }
+    WorkerCounters& counters = m_counters[index];
+    uint64_t last = WorkerCounters::NowNs();
     while (m_running.load())
     {
         Task task;
-        auto status = m_taskQueue.TakeTask(task, index);
+        auto status = m_taskQueue.TakeTask(task, index, &counters);
+        uint64_t taken = WorkerCounters::NowNs();
+        WorkerCounters::Add(counters.idleNs, taken - last);
+        last = taken;
         if (status == QueueStatus::OK)
         {
             task();
+            m_idle.Completed();
+            last = WorkerCounters::NowNs();
+            WorkerCounters::Add(counters.busyNs, last - taken);
+            WorkerCounters::Add(counters.executed, 1);
         }
         else if (status == QueueStatus::STOPPED)
         {
@@ -63,8 +98,10 @@ void WorkStealingThreadPool::Stop()
 {
     if (!m_running.load()) return;
 
+    m_timer.Stop(); // 先停定时线程，它可能正在向队列派发到期任务
     m_running = false;
     m_taskQueue.Stop(false);
+    m_idle.Close(); // 剩余任务不再执行，WaitIdle 的等待者直接返回
 
     for (auto& t : m_workers)
     {
@@ -81,17 +118,98 @@ void WorkStealingThreadPool::StopThreadPool()
     std::call_once(m_flag, [this]{ Stop(); });
 }
 
-void WorkStealingThreadPool::AddTask(Task&& task)
+ThreadPoolStats WorkStealingThreadPool::GetStats() const
 {
-    if (!m_running.load()) return;
-    size_t bucket = m_roundRobin.fetch_add(1) % m_threadnum;
-    m_taskQueue.AddTask(std::forward<Task>(task), bucket);
+    ThreadPoolStats stats;
+    stats.workers.resize(m_threadnum);
+    for (size_t i = 0; i < m_threadnum; ++i)
+    {
+        stats.workers[i].Load(m_counters[i]);
+        stats.workers[i].queueHighWatermark = m_taskQueue.HighWatermark(i);
+        stats.total += stats.workers[i];
+    }
+    stats.threadCount = m_running.load() ? m_threadnum : 0;
+    stats.idleThreads = m_taskQueue.Spinning() + m_taskQueue.Sleeping();
+    stats.queueSize = m_taskQueue.Size();
+    stats.queueHighWatermark = stats.total.queueHighWatermark;
+    stats.rejectedTasks = m_taskQueue.GetBackpressure().Rejected();
+    stats.droppedTasks = m_taskQueue.GetBackpressure().Dropped();
+    stats.cancelledTasks = m_cancelledTasks.load(std::memory_order_relaxed);
+    return stats;
 }
 
-void WorkStealingThreadPool::AddTask(const Task& task)
+bool WorkStealingThreadPool::InWorkerThread() const
 {
-    if (!m_running.load()) return;
-    size_t bucket = m_roundRobin.fetch_add(1) % m_threadnum;
-    m_taskQueue.AddTask(task, bucket);
+    return t_currentPool == this;
 }
 
+SubmitStatus WorkStealingThreadPool::AddTask(Task&& task)
+{
+    if (!m_running.load()) return SubmitStatus::Stopped;
+    m_idle.Submitted(); // 先计入再入队，工作线程不会在计入之前完成它
+    SubmitStatus result = Enqueue(std::move(task));
+    if (result != SubmitStatus::Queued) m_idle.Completed();
+    return result;
+}
+
+SubmitStatus WorkStealingThreadPool::Enqueue(Task&& task)
+{
+    if (InWorkerThread())
+    {
+        // 工作线程派生的子任务放入自己的本地队列，保持缓存热度并由 LIFO 弹出
+        if (m_taskQueue.PushLocal(std::move(task), t_workerIndex)) return SubmitStatus::Queued;
+        task(); // 本地队列已满，由调用者直接执行，避免工作线程阻塞在自己的队列上
+        return SubmitStatus::RanInCaller;
+    }
+    // 先只 try_lock 本分片和下一个桶，被其他生产者或窃取者占用时换桶，都不成功再在本分片上按背压策略提交
+    size_t bucket = SubmitShard(m_threadnum);
+    size_t probes = m_threadnum < 2 ? m_threadnum : 2;
+    for (size_t probe = 0; probe < probes; ++probe)
+    {
+        if (m_taskQueue.TryAddUncontended(std::move(task), (bucket + probe) % m_threadnum))
+        {
+            if (probe > 0) SkipSubmitShard(probe);
+            return SubmitStatus::Queued;
+        }
+    }
+    QueueStatus status = m_taskQueue.AddTask(std::forward<Task>(task), bucket);
+    return m_taskQueue.GetBackpressure().Complete(status, task);
+}
+
+bool WorkStealingThreadPool::TryAddTask(Task&& task)
+{
+    if (!m_running.load()) return false;
+    m_idle.Submitted();
+    bool added = InWorkerThread()
+        ? m_taskQueue.PushLocal(std::move(task), t_workerIndex)
+        : m_taskQueue.TryAddTask(std::move(task), SubmitShard(m_threadnum));
+    if (!added) m_idle.Completed();
+    return added;
+}
+
+bool WorkStealingThreadPool::RunPendingTask()
+{
+    // 外部线程没有自己的桶，传入越界下标只做窃取
+    // 工作线程在此执行的任务计入自己的 executed，耗时已包含在外层任务的 busyNs 中
+    if (!InWorkerThread())
+    {
+        Task task;
+        if (!m_taskQueue.TryTakeTask(task, m_threadnum)) return false;
+        task();
+        m_idle.Completed();
+        return true;
+    }
+    WorkerCounters& counters = m_counters[t_workerIndex];
+    Task task;
+    if (!m_taskQueue.TryTakeTask(task, t_workerIndex, &counters)) return false;
+    task();
+    m_idle.Completed();
+    WorkerCounters::Add(counters.executed, 1);
+    return true;
+}
+
+bool WorkStealingThreadPool::WantsWork() const
+{
+    if (m_taskQueue.Spinning() + m_taskQueue.Sleeping() > 0) return true;
+    return InWorkerThread() && m_taskQueue.Empty(t_workerIndex);
+}
@@ -0,0 +1,516 @@
+#include "../ThreadPool/include/CacheThreadPool.h"
+#include "../ThreadPool/include/FixedThreadPool.h"
+#include "../ThreadPool/include/WorkStealingThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 线程池基准测试：在同一台机器上比较三种线程池及两种队列后端
+//   throughput：空任务吞吐量，扫描线程数与生产者数
+//   latency：提交到开始执行的延迟分位数，分稳定到达与突发到达两种模式
+//   forkjoin：工作线程递归派生子任务（fib / nqueens）
+//   alloc：捕获超出内联容量的任务与带返回值的任务，比较 TaskArena 与直接使用全局分配器
+// 用法：bench_threadpool [--quick] [--alloc] [--csv 文件] [--json 文件] [--threads 1,2,4] [--producers 1,2,4]
+// --alloc 只运行 alloc 基准
+// 未指定 --csv 时 CSV 输出到标准输出
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchResult
+{
+    std::string bench;
+    std::string pool;
+    std::string mode;
+    size_t threads = 0;
+    size_t producers = 0;
+    size_t tasks = 0;
+    double seconds = 0;
+    double opsPerSec = 0;
+    double p50us = 0;
+    double p90us = 0;
+    double p99us = 0;
+    double maxus = 0;
+};
+
+struct BenchConfig
+{
+    bool quick = false;
+    bool allocOnly = false;
+    std::string csvPath;
+    std::string jsonPath;
+    std::vector<size_t> threads;
+    std::vector<size_t> producers;
+};
+
+std::vector<size_t> ParseList(const char* text)
+{
+    std::vector<size_t> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        if (!item.empty()) values.push_back(std::stoul(item));
+    }
+    return values;
+}
+
+BenchConfig ParseArgs(int argc, char** argv)
+{
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--quick") == 0) config.quick = true;
+        else if (std::strcmp(argv[i], "--alloc") == 0) config.allocOnly = true;
+        else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc) config.csvPath = argv[++i];
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) config.jsonPath = argv[++i];
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) config.threads = ParseList(argv[++i]);
+        else if (std::strcmp(argv[i], "--producers") == 0 && i + 1 < argc) config.producers = ParseList(argv[++i]);
+        else
+        {
+            std::cerr << "未知参数: " << argv[i] << std::endl;
+            std::exit(1);
+        }
+    }
+    if (config.threads.empty())
+    {
+        size_t hc = std::max(1u, std::thread::hardware_concurrency());
+        config.threads = {1, 2, 4};
+        if (hc > 4) config.threads.push_back(hc);
+    }
+    if (config.producers.empty()) config.producers = {1, 2, 4};
+    if (std::find(config.threads.begin(), config.threads.end(), size_t(0)) != config.threads.end() ||
+        std::find(config.producers.begin(), config.producers.end(), size_t(0)) != config.producers.end())
+    {
+        std::cerr << "--threads 与 --producers 的取值必须大于 0" << std::endl;
+        std::exit(1);
+    }
+    return config;
+}
+
+// 各线程池按统一的名字与线程数构造
+template<typename Pool>
+struct PoolTraits;
+
+template<>
+struct PoolTraits<FixedThreadPool>
+{
+    static std::unique_ptr<FixedThreadPool> Make(size_t threads, QueueBackend backend)
+    {
+        return std::make_unique<FixedThreadPool>(static_cast<int>(threads), backend);
+    }
+};
+template<>
+struct PoolTraits<CacheThreadPool>
+{
+    static std::unique_ptr<CacheThreadPool> Make(size_t threads, QueueBackend backend)
+    {
+        return std::make_unique<CacheThreadPool>(static_cast<int>(threads), static_cast<int>(threads), backend);
+    }
+};
+template<>
+struct PoolTraits<WorkStealingThreadPool>
+{
+    static std::unique_ptr<WorkStealingThreadPool> Make(size_t threads, QueueBackend)
+    {
+        return std::make_unique<WorkStealingThreadPool>(static_cast<int>(threads));
+    }
+};
+
+// 等待 counter 达到 target；未被线程池接受的任务不会执行，调用方需要从 target 中扣除
+void WaitFor(const std::atomic<size_t>& counter, size_t target)
+{
+    while (counter.load(std::memory_order_acquire) < target) std::this_thread::yield();
+}
+
+void FillPercentiles(BenchResult& result, std::vector<double>& samples)
+{
+    if (samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double q){ return samples[std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()))]; };
+    result.p50us = at(0.50);
+    result.p90us = at(0.90);
+    result.p99us = at(0.99);
+    result.maxus = samples.back();
+}
+
+// 空任务吞吐量：producers 个线程同时提交共 taskCount 个空任务，计时到被接受的任务全部执行完毕
+template<typename Pool>
+BenchResult BenchThroughput(const std::string& name, QueueBackend backend,
+                            size_t threads, size_t producers, size_t taskCount)
+{
+    auto pool = PoolTraits<Pool>::Make(threads, backend);
+    std::atomic<size_t> done{0};
+    std::atomic<size_t> lost{0};
+    std::atomic<bool> go{false};
+    size_t perProducer = taskCount / producers;
+    size_t total = perProducer * producers;
+
+    std::vector<std::thread> submitters;
+    for (size_t p = 0; p < producers; ++p)
+    {
+        submitters.emplace_back([&]
+        {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (size_t i = 0; i < perProducer; ++i)
+            {
+                if (!Accepted(pool->AddTask([&done]{ done.fetch_add(1, std::memory_order_release); })))
+                {
+                    lost.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : submitters) t.join();
+    total -= lost.load();
+    WaitFor(done, total);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    BenchResult result;
+    result.bench = "throughput";
+    result.pool = name;
+    result.mode = "burst";
+    result.threads = threads;
+    result.producers = producers;
+    result.tasks = total;
+    result.seconds = seconds;
+    result.opsPerSec = total / seconds;
+    return result;
+}
+
+// 分配开销：每个生产者交替提交 128 字节捕获的任务与 AddTaskWithReturn 任务，
+// 任务闭包与 promise 共享状态由生产者线程分配、在工作线程上释放。arena 为 false 时关闭 TaskArena
+template<typename Pool>
+BenchResult BenchAlloc(const std::string& name, QueueBackend backend,
+                       size_t threads, size_t producers, size_t taskCount, bool arena)
+{
+    TaskArena::SetEnabled(arena);
+    auto pool = PoolTraits<Pool>::Make(threads, backend);
+    std::atomic<size_t> done{0};
+    std::atomic<size_t> lost{0};
+    std::atomic<bool> go{false};
+    size_t perProducer = taskCount / producers;
+    size_t total = perProducer * producers;
+
+    std::vector<std::thread> submitters;
+    for (size_t p = 0; p < producers; ++p)
+    {
+        submitters.emplace_back([&]
+        {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            std::array<char, 128> payload{};
+            for (size_t i = 0; i < perProducer; ++i)
+            {
+                bool accepted;
+                if (i % 2 == 0)
+                {
+                    accepted = Accepted(pool->AddTask([&done, payload]
+                    {
+                        (void)payload;
+                        done.fetch_add(1, std::memory_order_release);
+                    }));
+                }
+                else
+                {
+                    // future 直接丢弃：共享状态在工作线程设置结果后由最后一个持有者释放；未被接受时 future 无效
+                    accepted = pool->AddTaskWithReturn([&done]
+                    {
+                        done.fetch_add(1, std::memory_order_release);
+                        return 0;
+                    }).valid();
+                }
+                if (!accepted) lost.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : submitters) t.join();
+    total -= lost.load();
+    WaitFor(done, total);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    pool.reset();
+    TaskArena::SetEnabled(true);
+
+    BenchResult result;
+    result.bench = "alloc";
+    result.pool = name;
+    result.mode = arena ? "arena" : "malloc";
+    result.threads = threads;
+    result.producers = producers;
+    result.tasks = total;
+    result.seconds = seconds;
+    result.opsPerSec = total / seconds;
+    return result;
+}
+
+// 提交到开始执行的延迟：steady 每隔一段时间提交一个任务，burst 每次连续提交一批后暂停；未被接受的任务不计入样本
+template<typename Pool>
+BenchResult BenchLatency(const std::string& name, QueueBackend backend, size_t threads,
+                         bool burst, size_t rounds)
+{
+    auto pool = PoolTraits<Pool>::Make(threads, backend);
+    const size_t burstSize = burst ? 64 : 1;
+    const auto gap = burst ? std::chrono::microseconds(2000) : std::chrono::microseconds(200);
+
+    std::vector<Clock::time_point> submitted(rounds * burstSize);
+    std::vector<Clock::time_point> started(rounds * burstSize);
+    std::vector<char> accepted(rounds * burstSize, 0);
+    std::atomic<size_t> done{0};
+    size_t expected = 0;
+
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        std::this_thread::sleep_for(gap);
+        for (size_t i = 0; i < burstSize; ++i)
+        {
+            size_t slot = r * burstSize + i;
+            submitted[slot] = Clock::now();
+            accepted[slot] = Accepted(pool->AddTask([&started, &done, slot]
+            {
+                started[slot] = Clock::now();
+                done.fetch_add(1, std::memory_order_release);
+            }));
+            expected += accepted[slot];
+        }
+        WaitFor(done, expected);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> samples;
+    samples.reserve(expected);
+    for (size_t i = 0; i < submitted.size(); ++i)
+    {
+        if (!accepted[i]) continue;
+        samples.push_back(std::chrono::duration<double, std::micro>(started[i] - submitted[i]).count());
+    }
+
+    BenchResult result;
+    result.bench = "latency";
+    result.pool = name;
+    result.mode = burst ? "burst" : "steady";
+    result.threads = threads;
+    result.producers = 1;
+    result.tasks = samples.size();
+    result.seconds = seconds;
+    result.opsPerSec = samples.size() / seconds;
+    FillPercentiles(result, samples);
+    return result;
+}
+
+// fork-join：任务在工作线程内递归派生子任务，前 spawnDepth 层并行，之后串行计算
+// 子任务用 TryAddTask 提交，队列已满时就地执行，工作线程不会阻塞在有界队列上，三种线程池使用同样的派生深度
+long FibSerial(int n)
+{
+    return n < 2 ? n : FibSerial(n - 1) + FibSerial(n - 2);
+}
+
+template<typename Pool>
+struct ForkJoin
+{
+    Pool* pool;
+    int spawnDepth;
+    std::atomic<long> sum{0};
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> spawned{0};
+
+    void Spawn(int depth, uint32_t a, uint32_t b, uint32_t c, uint32_t d, void (*body)(ForkJoin*, int, uint32_t, uint32_t, uint32_t, uint32_t))
+    {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        spawned.fetch_add(1, std::memory_order_relaxed);
+        typename Pool::Task task([this, depth, a, b, c, d, body]
+        {
+            body(this, depth, a, b, c, d);
+            pending.fetch_sub(1, std::memory_order_release);
+        });
+        if (!pool->TryAddTask(std::move(task))) task();
+    }
+
+    static void Fib(ForkJoin* fj, int depth, uint32_t n, uint32_t, uint32_t, uint32_t)
+    {
+        if (depth >= fj->spawnDepth || n < 2)
+        {
+            fj->sum.fetch_add(FibSerial(static_cast<int>(n)), std::memory_order_relaxed);
+            return;
+        }
+        fj->Spawn(depth + 1, n - 1, 0, 0, 0, &Fib);
+        fj->Spawn(depth + 1, n - 2, 0, 0, 0, &Fib);
+    }
+
+    static long QueensSerial(uint32_t size, uint32_t row, uint32_t cols, uint32_t diag1, uint32_t diag2)
+    {
+        if (row == size) return 1;
+        long count = 0;
+        uint32_t full = (1u << size) - 1;
+        uint32_t free = ~(cols | diag1 | diag2) & full;
+        while (free)
+        {
+            uint32_t bit = free & (0u - free);
+            free ^= bit;
+            count += QueensSerial(size, row + 1, cols | bit, ((diag1 | bit) << 1) & full, (diag2 | bit) >> 1);
+        }
+        return count;
+    }
+    // a = 棋盘大小 | 行号 << 8，b/c/d = 列与两条对角线的占用位
+    static void Queens(ForkJoin* fj, int depth, uint32_t a, uint32_t cols, uint32_t diag1, uint32_t diag2)
+    {
+        uint32_t size = a & 0xff;
+        uint32_t row = a >> 8;
+        if (depth >= fj->spawnDepth || row == size)
+        {
+            fj->sum.fetch_add(QueensSerial(size, row, cols, diag1, diag2), std::memory_order_relaxed);
+            return;
+        }
+        uint32_t full = (1u << size) - 1;
+        uint32_t free = ~(cols | diag1 | diag2) & full;
+        while (free)
+        {
+            uint32_t bit = free & (0u - free);
+            free ^= bit;
+            fj->Spawn(depth + 1, size | ((row + 1) << 8), cols | bit,
+                      ((diag1 | bit) << 1) & full, (diag2 | bit) >> 1, &Queens);
+        }
+    }
+};
+
+template<typename Pool>
+BenchResult BenchForkJoin(const std::string& name, QueueBackend backend, size_t threads,
+                          bool queens, int problem, int spawnDepth, long expected)
+{
+    auto pool = PoolTraits<Pool>::Make(threads, backend);
+    ForkJoin<Pool> fj;
+    fj.pool = pool.get();
+    fj.spawnDepth = spawnDepth;
+
+    auto start = Clock::now();
+    if (queens) fj.Spawn(0, static_cast<uint32_t>(problem), 0, 0, 0, &ForkJoin<Pool>::Queens);
+    else fj.Spawn(0, static_cast<uint32_t>(problem), 0, 0, 0, &ForkJoin<Pool>::Fib);
+    while (fj.pending.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (fj.sum.load() != expected)
+    {
+        std::cerr << name << " " << (queens ? "nqueens" : "fib") << " 结果错误: "
+                  << fj.sum.load() << " != " << expected << std::endl;
+        std::exit(1);
+    }
+
+    BenchResult result;
+    result.bench = queens ? "forkjoin_nqueens" : "forkjoin_fib";
+    result.pool = name;
+    result.mode = "depth" + std::to_string(spawnDepth);
+    result.threads = threads;
+    result.producers = 1;
+    result.tasks = fj.spawned.load();
+    result.seconds = seconds;
+    result.opsPerSec = result.tasks / seconds;
+    return result;
+}
+
+template<typename Pool>
+void RunPool(const std::string& name, QueueBackend backend, const BenchConfig& config,
+             std::vector<BenchResult>& results)
+{
+    const size_t throughputTasks = config.quick ? 20000 : 200000;
+    const size_t latencyRounds = config.quick ? 50 : 500;
+    const int fibN = config.quick ? 24 : 30;
+    const long fibExpected = FibSerial(fibN);
+    const int queensN = config.quick ? 9 : 11;
+    const long queensExpected = ForkJoin<Pool>::QueensSerial(queensN, 0, 0, 0, 0);
+    const int fibDepth = 14;
+    const int queensDepth = 3;
+
+    for (size_t threads : config.threads)
+    {
+        for (size_t producers : config.producers)
+        {
+            results.push_back(BenchAlloc<Pool>(name, backend, threads, producers, throughputTasks, true));
+            results.push_back(BenchAlloc<Pool>(name, backend, threads, producers, throughputTasks, false));
+            std::cerr << "." << std::flush;
+        }
+        if (config.allocOnly) continue;
+
+        for (size_t producers : config.producers)
+        {
+            results.push_back(BenchThroughput<Pool>(name, backend, threads, producers, throughputTasks));
+            std::cerr << "." << std::flush;
+        }
+        results.push_back(BenchLatency<Pool>(name, backend, threads, false, latencyRounds));
+        results.push_back(BenchLatency<Pool>(name, backend, threads, true, latencyRounds / 5));
+        results.push_back(BenchForkJoin<Pool>(name, backend, threads, false, fibN, fibDepth, fibExpected));
+        results.push_back(BenchForkJoin<Pool>(name, backend, threads, true, queensN, queensDepth, queensExpected));
+        std::cerr << "." << std::flush;
+    }
+}
+
+void WriteCsv(std::ostream& out, const std::vector<BenchResult>& results)
+{
+    out << "bench,pool,mode,threads,producers,tasks,seconds,ops_per_sec,p50_us,p90_us,p99_us,max_us\n";
+    for (const auto& r : results)
+    {
+        out << r.bench << ',' << r.pool << ',' << r.mode << ',' << r.threads << ',' << r.producers << ','
+            << r.tasks << ',' << r.seconds << ',' << r.opsPerSec << ',' << r.p50us << ',' << r.p90us << ','
+            << r.p99us << ',' << r.maxus << '\n';
+    }
+}
+
+void WriteJson(std::ostream& out, const std::vector<BenchResult>& results)
+{
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& r = results[i];
+        out << "  {\"bench\": \"" << r.bench << "\", \"pool\": \"" << r.pool << "\", \"mode\": \"" << r.mode
+            << "\", \"threads\": " << r.threads << ", \"producers\": " << r.producers
+            << ", \"tasks\": " << r.tasks << ", \"seconds\": " << r.seconds
+            << ", \"ops_per_sec\": " << r.opsPerSec << ", \"p50_us\": " << r.p50us
+            << ", \"p90_us\": " << r.p90us << ", \"p99_us\": " << r.p99us << ", \"max_us\": " << r.maxus
+            << (i + 1 < results.size() ? "},\n" : "}\n");
+    }
+    out << "]\n";
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config = ParseArgs(argc, argv);
+    std::vector<BenchResult> results;
+
+    RunPool<FixedThreadPool>("fixed_ring", QueueBackend::RingBuffer, config, results);
+    RunPool<FixedThreadPool>("fixed_list", QueueBackend::List, config, results);
+    RunPool<FixedThreadPool>("fixed_sharded", QueueBackend::Sharded, config, results);
+    RunPool<CacheThreadPool>("cache_ring", QueueBackend::RingBuffer, config, results);
+    RunPool<CacheThreadPool>("cache_list", QueueBackend::List, config, results);
+    RunPool<CacheThreadPool>("cache_sharded", QueueBackend::Sharded, config, results);
+    RunPool<WorkStealingThreadPool>("workstealing", QueueBackend::RingBuffer, config, results);
+    std::cerr << std::endl;
+
+    if (config.csvPath.empty())
+    {
+        WriteCsv(std::cout, results);
+    }
+    else
+    {
+        std::ofstream csv(config.csvPath);
+        WriteCsv(csv, results);
+    }
+    if (!config.jsonPath.empty())
+    {
+        std::ofstream json(config.jsonPath);
+        WriteJson(json, results);
+    }
+    return 0;
+}
@@ -1,36 +1,14 @@
 #include "../ThreadPool/include/CacheThreadPool.h"
+#include "stress_common.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <future>
 #include <iostream>
 #include <thread>
 #include <vector>
 
-int countPrimes(int start, int end)
-{
-    int count = 0;
-    for (int i = start; i <= end; ++i)
-    {
-        if (i < 2) continue;
-        bool isPrime = true;
-        for (int j = 2; j * j <= i; ++j)
-        {
-            if (i % j == 0)
-            {
-                isPrime = false;
-                break;
-            }
-        }
-        if (isPrime) ++count;
-    }
-    return count;
-}
-
-void simulateIO(int milliseconds)
-{
-    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
-}
-
 int main()
 {
     std::cout << "=== CacheThreadPool 压力测试 ===" << std::endl;
@@ -104,6 +82,141 @@ int main()
                   << " ms\n";
     }
 
+    // 测试4: 批量提交，一次入队并按任务数唤醒线程
+    if (!BulkSubmit(pool, 600, 150)) return 1;
+
+    // 测试5: 唤醒延迟与空闲 CPU 开销
+    if (!WakeLatencyAndIdleCpu(pool)) return 1;
+
+    // 测试6: 运行统计快照，不停止工作线程
+    if (!StatsSnapshot(pool)) return 1;
+
+    // 测试7: 优先级通道，后台低优先级任务积压时高优先级任务的排队延迟
+    if (!PriorityLanes(pool)) return 1;
+
+    // 测试8: 突发 IO 任务，积压时线程数从核心线程数扩展到最大线程数；
+    // 空闲超时后多出的线程退役，其中一部分停靠待命，第二轮突发时一次唤醒即可重新激活
+    {
+        const int taskCount = 200;
+        const size_t coreThreads = 2;
+        CacheThreadPool burstPool(static_cast<int>(coreThreads), 16);
+        burstPool.SetStandbyThreads(8);
+        for (int round = 1; round <= 2; ++round)
+        {
+            std::atomic<int> finished{0};
+            size_t peakThreads = 0;
+            auto burstStart = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < taskCount; ++i)
+            {
+                burstPool.AddTask([&finished]{
+                    simulateIO(10);
+                    finished++;
+                });
+            }
+            while (finished.load() < taskCount)
+            {
+                peakThreads = std::max(peakThreads, burstPool.GetStats().threadCount);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            auto burstEnd = std::chrono::high_resolution_clock::now();
+            std::cout << "第 " << round << " 轮突发 IO 任务 " << taskCount
+                      << " 个（核心 2 线程，最大 16 线程）完成，峰值线程数: " << peakThreads << "，耗时: "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(burstEnd - burstStart).count()
+                      << " ms\n";
+            if (peakThreads <= coreThreads)
+            {
+                std::cout << "错误: 积压时线程数应超过核心线程数 " << coreThreads << "\n";
+                return 1;
+            }
+            if (round == 1)
+            {
+                // 多出的线程空闲 KeepAliveTime 秒后退役，轮询到只剩核心线程，留出余量作为期限
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(KeepAliveTime + 5);
+                ThreadPoolStats stats = burstPool.GetStats();
+                while (stats.threadCount > coreThreads && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    stats = burstPool.GetStats();
+                }
+                std::cout << "空闲回收后 活动线程: " << stats.threadCount << "，待命线程: " << stats.standbyThreads << "\n";
+                if (stats.threadCount > coreThreads || stats.standbyThreads == 0)
+                {
+                    std::cout << "错误: 空闲超时后多出的线程应退役，其中一部分停靠待命\n";
+                    return 1;
+                }
+            }
+        }
+    }
+
+    // 测试9: 过载时带截止时间的请求，积压中已过期的任务出队后直接丢弃；
+    // 同一个取消源的一批任务一次取消，不必遍历队列
+    {
+        const int requestCount = 400;
+        CacheThreadPool overloaded(2, 2);
+        std::atomic<int> served{0};
+        std::vector<std::future<int>> replies;
+        auto overloadStart = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < requestCount; ++i)
+        {
+            // 每个请求处理 1 ms，上游只等待 20 ms
+            replies.push_back(overloaded.AddTaskWithReturn(
+                TaskGuard::Within(std::chrono::milliseconds(20)),
+                [&served, i]
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    served++;
+                    return i;
+                }));
+        }
+        int expired = 0;
+        for (auto& reply : replies)
+        {
+            try
+            {
+                reply.get();
+            }
+            catch (const TaskCancelled&)
+            {
+                ++expired;
+            }
+        }
+        auto overloadEnd = std::chrono::high_resolution_clock::now();
+
+        CancellationSource batch;
+        std::atomic<int> batchRan{0};
+        std::atomic<bool> release{false};
+        overloaded.AddTask([&release]{ while (!release.load()) std::this_thread::yield(); });
+        overloaded.AddTask([&release]{ while (!release.load()) std::this_thread::yield(); });
+        for (int i = 0; i < 100; ++i)
+        {
+            overloaded.AddTask(TaskGuard(batch.Token()), [&batchRan]{ batchRan++; });
+        }
+        auto cancelStart = std::chrono::high_resolution_clock::now();
+        batch.Cancel();
+        auto cancelEnd = std::chrono::high_resolution_clock::now();
+        release = true;
+        overloaded.WaitIdle();
+
+        std::cout << "截止时间 " << requestCount << " 个请求耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(overloadEnd - overloadStart).count()
+                  << " ms，执行: " << served.load() << "，过期丢弃: " << expired << "\n";
+        std::cout << "  批量取消 100 个排队任务耗时: "
+                  << std::chrono::duration_cast<std::chrono::nanoseconds>(cancelEnd - cancelStart).count()
+                  << " ns，取消后仍执行: " << batchRan.load() << "，累计丢弃: "
+                  << overloaded.GetStats().cancelledTasks << "\n";
+        if (expired == 0 || served.load() + expired != requestCount || batchRan.load() != 0)
+        {
+            std::cout << "错误: 积压中应有请求因超过截止时间被丢弃，每个请求要么执行要么过期，已取消的任务不应执行\n";
+            return 1;
+        }
+    }
+
+    // 测试10: 同一批提交的任务互相等待，核心线程数为 2 时也不会死锁
+    {
+        CacheThreadPool burstPool(2, 2);
+        if (!BurstMutualWait(burstPool, "CacheThreadPool")) return 1;
+    }
+
     std::cout << "=== CacheThreadPool 压力测试结束 ===" << std::endl;
     return 0;
 }
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "../SyncQueue/PriorityLanes.hpp"
+#include "../ThreadPool/include/ThreadPoolStats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+// 几个压力测试共用的测试，Pool 为被测线程池类型；返回 false 表示检查失败，错误信息已经输出
+
+inline int countPrimes(int start, int end)
+{
+    int count = 0;
+    for (int i = start; i <= end; ++i)
+    {
+        if (i < 2) continue;
+        bool isPrime = true;
+        for (int j = 2; j * j <= i; ++j)
+        {
+            if (i % j == 0)
+            {
+                isPrime = false;
+                break;
+            }
+        }
+        if (isPrime) ++count;
+    }
+    return count;
+}
+
+inline void simulateIO(int milliseconds)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+}
+
+// 批量提交，一次入队并按任务数唤醒线程；每个任务统计一段区间内的素数，结果之和必须等于串行计算的结果
+template<typename Pool>
+bool BulkSubmit(Pool& pool, int taskCount, int span)
+{
+    auto makeJob = [](int start, int end){ return [start, end]{ return countPrimes(start, end); }; };
+    std::vector<decltype(makeJob(0, 0))> jobs;
+    jobs.reserve(taskCount);
+    for (int i = 0; i < taskCount; ++i)
+    {
+        jobs.emplace_back(makeJob(i * span, (i + 1) * span - 1));
+    }
+    auto batchStart = std::chrono::high_resolution_clock::now();
+    auto futures = pool.AddTasksWithReturn(jobs.begin(), jobs.end());
+    int total = 0;
+    for (auto& f : futures) total += f.get();
+    auto now = std::chrono::high_resolution_clock::now();
+    std::cout << "批量计算任务 " << futures.size() << " 个完成，素数总数: "
+              << total << "，耗时: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(now - batchStart).count()
+              << " ms\n";
+
+    int expected = countPrimes(0, taskCount * span - 1);
+    if (futures.size() != static_cast<size_t>(taskCount) || total != expected)
+    {
+        std::cout << "错误: 批量提交丢失任务，期望 " << taskCount << " 个任务、素数总数 " << expected << "\n";
+        return false;
+    }
+    return true;
+}
+
+// 唤醒延迟与空闲 CPU 开销：池空闲后提交单个任务，测量从提交到任务开始执行的时间；
+// 之后池完全空闲一段时间，进程消耗的 CPU 时间应接近 0，超过一半说明空闲线程没有睡眠
+template<typename Pool>
+bool WakeLatencyAndIdleCpu(Pool& pool)
+{
+    const int rounds = 200;
+    std::vector<long long> latencies;
+    latencies.reserve(rounds);
+    for (int i = 0; i < rounds; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        auto submitTime = std::chrono::steady_clock::now();
+        auto f = pool.AddTaskWithReturn([]{ return std::chrono::steady_clock::now(); });
+        auto startedAt = f.get();
+        latencies.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(startedAt - submitTime).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    long long sum = 0;
+    for (auto ns : latencies) sum += ns;
+    std::cout << "唤醒延迟 平均: " << sum / rounds / 1000.0 << " us，p50: "
+              << latencies[rounds / 2] / 1000.0 << " us，p99: "
+              << latencies[rounds * 99 / 100] / 1000.0 << " us\n";
+
+    const auto idleWall = std::chrono::milliseconds(300);
+    std::clock_t cpuStart = std::clock();
+    std::this_thread::sleep_for(idleWall);
+    double cpuMs = 1000.0 * (std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    std::cout << "空闲 " << idleWall.count() << " ms 期间 CPU 时间: " << cpuMs << " ms\n";
+    if (cpuMs > idleWall.count() / 2.0)
+    {
+        std::cout << "错误: 线程池空闲时仍在消耗 CPU\n";
+        return false;
+    }
+    return true;
+}
+
+// 运行统计快照，不停止工作线程；等到池空闲后读取，排队任务数必须为 0，之前的测试执行过的任务必须已经计入
+template<typename Pool>
+bool StatsSnapshot(Pool& pool)
+{
+    pool.WaitIdle();
+    ThreadPoolStats stats = pool.GetStats();
+    std::cout << "运行统计 线程数: " << stats.threadCount << "，空闲线程: " << stats.idleThreads
+              << "，排队任务: " << stats.queueSize << "，队列历史最大长度: " << stats.queueHighWatermark << "\n";
+    std::cout << "  合计 执行: " << stats.total.executed << "，窃取: " << stats.total.stolen
+              << "（尝试 " << stats.total.stealAttempts << "，失败 " << stats.total.stealFailures << "）"
+              << "，忙碌: " << stats.total.busyNs / 1000000 << " ms，空闲: " << stats.total.idleNs / 1000000 << " ms\n";
+    for (size_t i = 0; i < stats.workers.size(); ++i)
+    {
+        const auto& w = stats.workers[i];
+        if (w.executed == 0 && w.idleNs == 0) continue;
+        std::cout << "  worker " << i << " 执行: " << w.executed << "，窃取: " << w.stolen
+                  << "，忙碌: " << w.busyNs / 1000000 << " ms";
+        if (w.queueHighWatermark > 0) std::cout << "，队列历史最大长度: " << w.queueHighWatermark;
+        std::cout << "\n";
+    }
+    if (stats.queueSize != 0 || stats.total.executed == 0)
+    {
+        std::cout << "错误: 空闲线程池的统计快照不一致\n";
+        return false;
+    }
+    return true;
+}
+
+// 优先级通道：后台低优先级任务积压时测量高优先级任务的排队延迟，两类任务都必须全部执行
+template<typename Pool>
+bool PriorityLanes(Pool& pool)
+{
+    const int backgroundCount = 1000;
+    const int interactiveCount = 100;
+    std::atomic<int> backgroundDone{0};
+    // 低优先级通道有容量上限，由单独的线程提交，满时只阻塞该线程
+    std::thread background([&]
+    {
+        for (int i = 0; i < backgroundCount; ++i)
+        {
+            pool.AddTask(TaskPriority::Low, [&backgroundDone, i]
+            {
+                countPrimes(i * 200, (i + 1) * 200 - 1);
+                backgroundDone++;
+            });
+        }
+    });
+
+    std::vector<long long> latencies;
+    latencies.reserve(interactiveCount);
+    for (int i = 0; i < interactiveCount; ++i)
+    {
+        auto submitTime = std::chrono::steady_clock::now();
+        auto f = pool.AddTaskWithReturn(TaskPriority::High, []{ return std::chrono::steady_clock::now(); });
+        auto startedAt = f.get();
+        latencies.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(startedAt - submitTime).count());
+    }
+    background.join();
+    pool.WaitIdle();
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "高优先级任务延迟 p50: " << latencies[interactiveCount / 2] / 1000.0 << " us，p99: "
+              << latencies[interactiveCount * 99 / 100] / 1000.0 << " us（后台低优先级任务 "
+              << backgroundDone.load() << " 个完成）\n";
+    if (backgroundDone.load() != backgroundCount)
+    {
+        std::cout << "错误: 后台低优先级任务应完成 " << backgroundCount << " 个\n";
+        return false;
+    }
+    return true;
+}
+
+// 同一批提交的任务互相等待：每批开头是一个等待者和它等待的任务，后面跟着一串填充任务
+// 工作线程若把一批任务私自取走再逐个执行，等待者与被等待的任务落在同一个线程手里就会死锁；
+// 等待者最多等 waitLimit，超时计为卡住，测试结束时必须为 0
+template<typename Pool>
+bool BurstMutualWait(Pool& pool, const char* name)
+{
+    using Task = typename Pool::Task;
+    const int rounds = 200;
+    const int fillerCount = 30;
+    const auto waitLimit = std::chrono::seconds(2);
+
+    std::atomic<int> stuck{0};
+    std::atomic<int> executed{0};
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round)
+    {
+        std::promise<void> signal;
+        std::shared_future<void> signaled = signal.get_future().share();
+        std::vector<Task> burst;
+        burst.emplace_back([signaled, waitLimit, &stuck, &executed]
+        {
+            if (signaled.wait_for(waitLimit) != std::future_status::ready) stuck++;
+            executed++;
+        });
+        burst.emplace_back([&signal, &executed]
+        {
+            signal.set_value();
+            executed++;
+        });
+        for (int i = 0; i < fillerCount; ++i)
+        {
+            burst.emplace_back([&executed]{ executed++; });
+        }
+        pool.AddTasks(std::make_move_iterator(burst.begin()), std::make_move_iterator(burst.end()));
+        pool.WaitIdle();
+        if (stuck.load() != 0) break; // 已经证明会卡住，不必每批再等 waitLimit
+    }
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    const int expected = rounds * (fillerCount + 2);
+    std::cout << name << " 批内互相等待 " << rounds << " 批共 " << expected << " 个任务，执行: "
+              << executed.load() << "，卡住: " << stuck.load() << "，耗时: " << elapsedMs << " ms\n";
+    if (stuck.load() != 0 || executed.load() != expected)
+    {
+        std::cout << "错误: " << name << " 同一批中互相等待的任务没有被其他线程执行\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,134 @@
+#include "../ThreadPool/include/CoTask.h"
+#include "../ThreadPool/include/FixedThreadPool.h"
+#include "../ThreadPool/include/WorkStealingThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+int countPrimes(int start, int end)
+{
+    int count = 0;
+    for (int i = start; i <= end; ++i)
+    {
+        if (i < 2) continue;
+        bool isPrime = true;
+        for (int j = 2; j * j <= i; ++j)
+        {
+            if (i % j == 0)
+            {
+                isPrime = false;
+                break;
+            }
+        }
+        if (isPrime) ++count;
+    }
+    return count;
+}
+
+// 每一层都切换到线程池上执行，子协程完成后在同一个工作线程上直接恢复父协程
+CoTask<int> CountPrimesRange(WorkStealingThreadPool& pool, int start, int end)
+{
+    co_await pool.Schedule();
+    if (end - start < 2000) co_return countPrimes(start, end);
+    int mid = start + (end - start) / 2;
+    int left = co_await CountPrimesRange(pool, start, mid);
+    int right = co_await CountPrimesRange(pool, mid + 1, end);
+    co_return left + right;
+}
+
+// 模拟一次 I/O：挂起等待而不是在工作线程上 sleep
+template<typename Pool>
+CoTask<void> SimulatedRequest(Pool& pool, std::atomic<int>& done, std::chrono::milliseconds latency)
+{
+    co_await pool.Schedule();
+    co_await ResumeAfter(pool, latency);
+    countPrimes(0, 200);
+    done++;
+}
+
+CoTask<int> Fails(FixedThreadPool& pool)
+{
+    co_await pool.Schedule();
+    throw std::runtime_error("协程内抛出的异常");
+    co_return 0;
+}
+
+int main()
+{
+    std::cout << "=== 协程压力测试 ===" << std::endl;
+    const int threadnum = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+    WorkStealingThreadPool wsPool(threadnum);
+    FixedThreadPool fixedPool(threadnum);
+
+    // 测试1: co_await pool.Schedule() 切换到工作线程
+    {
+        auto hop = [](WorkStealingThreadPool& pool) -> CoTask<bool>
+        {
+            bool before = pool.InWorkerThread();
+            co_await pool.Schedule();
+            co_return !before && pool.InWorkerThread();
+        };
+        bool hopped = SyncWait(hop(wsPool));
+        std::cout << "切换到工作线程: " << (hopped ? "是" : "否") << "\n";
+        if (!hopped)
+        {
+            std::cout << "错误: co_await pool.Schedule() 之后应在工作线程上执行\n";
+            return 1;
+        }
+    }
+
+    // 测试2: 递归的惰性 CoTask，结果与直接计算一致
+    {
+        auto start = std::chrono::steady_clock::now();
+        int total = SyncWait(CountPrimesRange(wsPool, 0, 200000));
+        auto now = std::chrono::steady_clock::now();
+        int expected = countPrimes(0, 200000);
+        std::cout << "协程递归素数总数: " << total << "（直接计算: " << expected << "），耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count() << " ms\n";
+        if (total != expected)
+        {
+            std::cout << "错误: 协程递归的结果与直接计算不一致\n";
+            return 1;
+        }
+    }
+
+    // 测试3: 远多于线程数的并发逻辑操作，每个都“等待 I/O” 50 ms，工作线程不被阻塞
+    for (int round = 0; round < 2; ++round)
+    {
+        const int requestCount = 10000;
+        const auto latency = std::chrono::milliseconds(50);
+        std::atomic<int> done{0};
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < requestCount; ++i)
+        {
+            if (round == 0) Spawn(wsPool, SimulatedRequest(wsPool, done, latency));
+            else Spawn(fixedPool, SimulatedRequest(fixedPool, done, latency));
+        }
+        while (done.load() < requestCount) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        auto now = std::chrono::steady_clock::now();
+        std::cout << (round == 0 ? "WorkStealingThreadPool" : "FixedThreadPool") << " 并发请求 " << requestCount
+                  << " 个（" << threadnum << " 个线程，每个等待 " << latency.count() << " ms），总耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count() << " ms\n";
+    }
+
+    // 测试4: 异常沿 co_await 链传播到 SyncWait 的调用者
+    {
+        try
+        {
+            SyncWait(Fails(fixedPool));
+            std::cout << "错误: 异常没有传播到 SyncWait 的调用者\n";
+            return 1;
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "异常传播: " << e.what() << "\n";
+        }
+    }
+
+    std::cout << "=== 协程压力测试结束 ===" << std::endl;
+    return 0;
+}
@@ -1,36 +1,15 @@
 #include "../ThreadPool/include/FixedThreadPool.h"
+#include "../ThreadPool/include/TaskGroup.h"
+#include "stress_common.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <future>
 #include <iostream>
 #include <thread>
 #include <vector>
 
-int countPrimes(int start, int end)
-{
-    int count = 0;
-    for (int i = start; i <= end; ++i)
-    {
-        if (i < 2) continue;
-        bool isPrime = true;
-        for (int j = 2; j * j <= i; ++j)
-        {
-            if (i % j == 0)
-            {
-                isPrime = false;
-                break;
-            }
-        }
-        if (isPrime) ++count;
-    }
-    return count;
-}
-
-void simulateIO(int milliseconds)
-{
-    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
-}
-
 int main()
 {
     std::cout << "=== FixedThreadPool 压力测试 ===" << std::endl;
@@ -95,13 +74,237 @@ int main()
                 });
             }
         }
-        std::this_thread::sleep_for(std::chrono::seconds(2));
+        // 等待全部任务执行完毕，而不是固定睡眠
+        pool.WaitIdle();
         auto now = std::chrono::high_resolution_clock::now();
         std::cout << "混合任务 " << taskCount << " 个提交完成，总耗时: "
                   << std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime).count()
                   << " ms\n";
     }
 
+    // 测试4: 批量提交，一次入队并按任务数唤醒线程
+    if (!BulkSubmit(pool, 800, 200)) return 1;
+
+    // 测试5: 唤醒延迟与空闲 CPU 开销
+    if (!WakeLatencyAndIdleCpu(pool)) return 1;
+
+    // 测试6: 运行统计快照，不停止工作线程
+    if (!StatsSnapshot(pool)) return 1;
+
+    // 测试7: 优先级通道，后台低优先级任务积压时高优先级任务的排队延迟
+    if (!PriorityLanes(pool)) return 1;
+
+    // 测试8: 时间轮定时任务，大量未到期定时器不占用工作线程
+    {
+        const int timerCount = 20000;
+        std::atomic<int> fired{0};
+        std::atomic<long long> maxLateUs{0};
+        std::vector<TimerId> ids;
+        ids.reserve(timerCount);
+        auto scheduleStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < timerCount; ++i)
+        {
+            auto when = std::chrono::steady_clock::now() + std::chrono::milliseconds(10 + i % 200);
+            ids.push_back(pool.ScheduleAt(when, [&fired, &maxLateUs, when]
+            {
+                long long late = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - when).count();
+                long long prev = maxLateUs.load();
+                while (late > prev && !maxLateUs.compare_exchange_weak(prev, late)) {}
+                fired++;
+            }));
+        }
+        auto scheduleEnd = std::chrono::steady_clock::now();
+        // 取消一半尚未到期的定时器
+        int cancelled = 0;
+        for (int i = 0; i < timerCount; i += 2)
+        {
+            if (pool.CancelTimer(ids[i])) ++cancelled;
+        }
+        auto cancelEnd = std::chrono::steady_clock::now();
+
+        std::atomic<int> ticks{0};
+        TimerId periodic = pool.ScheduleEvery(std::chrono::milliseconds(20), [&ticks]{ ticks++; });
+
+        // 定时器等待期间工作线程仍然空闲，可以立即执行普通任务
+        auto probeStart = std::chrono::steady_clock::now();
+        pool.AddTaskWithReturn([]{ return 0; }).get();
+        auto probeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - probeStart).count();
+
+        // 最晚的定时器 210 ms 后到期，给足余量；超过期限仍未全部触发说明有定时任务丢失
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (fired.load() + cancelled < timerCount && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        pool.CancelTimer(periodic);
+
+        std::cout << "定时器 插入 " << timerCount << " 个耗时: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(scheduleEnd - scheduleStart).count()
+                  << " us，取消 " << cancelled << " 个耗时: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(cancelEnd - scheduleEnd).count()
+                  << " us\n";
+        std::cout << "  到期执行: " << fired.load() << "，最大延迟: " << maxLateUs.load() / 1000.0
+                  << " ms，周期任务执行: " << ticks.load() << " 次，等待期间普通任务响应: " << probeUs << " us\n";
+        if (fired.load() != timerCount - cancelled || ticks.load() == 0)
+        {
+            std::cout << "错误: 应有 " << timerCount - cancelled << " 个定时器到期执行，周期任务至少执行一次\n";
+            return 1;
+        }
+    }
+
+    // 测试9: 过载时的背压策略，比较提交线程的最长阻塞时间与被拒绝、就地执行、丢弃的任务数
+    {
+        const int taskCount = 5000;
+        struct PolicyCase
+        {
+            const char* name;
+            BackpressurePolicy policy;
+        };
+        const PolicyCase cases[] = {
+            {"Block", BackpressurePolicy::Block},
+            {"BlockWithTimeout", BackpressurePolicy::BlockWithTimeout},
+            {"Reject", BackpressurePolicy::Reject},
+            {"CallerRuns", BackpressurePolicy::CallerRuns},
+            {"DropOldest", BackpressurePolicy::DropOldest},
+        };
+        for (const PolicyCase& policyCase : cases)
+        {
+            FixedThreadPool overloaded(2);
+            overloaded.SetBackpressure(policyCase.policy, std::chrono::milliseconds(1));
+            std::atomic<int> executed{0};
+            int statusCount[5] = {0, 0, 0, 0, 0};
+            long long maxSubmitUs = 0;
+            auto policyStart = std::chrono::steady_clock::now();
+            for (int i = 0; i < taskCount; ++i)
+            {
+                auto submitStart = std::chrono::steady_clock::now();
+                SubmitStatus status = overloaded.AddTask([&executed]{
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    executed++;
+                });
+                maxSubmitUs = std::max(maxSubmitUs, static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - submitStart).count()));
+                statusCount[static_cast<int>(status)]++;
+            }
+            auto submitEnd = std::chrono::steady_clock::now();
+            overloaded.WaitIdle();
+            ThreadPoolStats stats = overloaded.GetStats();
+            std::cout << policyCase.name << " 提交 " << taskCount << " 个耗时: "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(submitEnd - policyStart).count()
+                      << " ms，单次最长阻塞: " << maxSubmitUs << " us，入队: " << statusCount[0]
+                      << "，就地执行: " << statusCount[1] << "，拒绝: " << statusCount[2]
+                      << "，超时: " << statusCount[3] << "，丢弃: " << stats.droppedTasks << "\n";
+
+            // 过载时每种策略都必须真正生效；池空闲后执行数 = 入队 + 就地执行 - 被挤掉的任务
+            bool applied = true;
+            switch (policyCase.policy)
+            {
+            case BackpressurePolicy::Block: applied = statusCount[0] == taskCount; break;
+            case BackpressurePolicy::Reject: applied = statusCount[2] > 0; break;
+            case BackpressurePolicy::CallerRuns: applied = statusCount[1] > 0; break;
+            case BackpressurePolicy::DropOldest: applied = stats.droppedTasks > 0; break;
+            default: break;
+            }
+            long long accounted = static_cast<long long>(statusCount[0]) + statusCount[1]
+                                  - static_cast<long long>(stats.droppedTasks);
+            if (!applied || accounted != executed.load())
+            {
+                std::cout << "错误: " << policyCase.name << " 策略没有生效，或执行数 " << executed.load()
+                          << " 与入队、就地执行、丢弃的任务数不符\n";
+                return 1;
+            }
+        }
+    }
+
+    // 测试10: 多个外部线程同时提交，比较三种队列后端
+    {
+        const int producerCount = 8;
+        const int perProducer = 20000;
+        struct BackendCase
+        {
+            const char* name;
+            QueueBackend backend;
+        };
+        const BackendCase cases[] = {
+            {"List", QueueBackend::List},
+            {"RingBuffer", QueueBackend::RingBuffer},
+            {"Sharded", QueueBackend::Sharded},
+        };
+        for (const BackendCase& backendCase : cases)
+        {
+            FixedThreadPool sharded(4, backendCase.backend);
+            std::atomic<int> executed{0};
+            auto submitStart = std::chrono::steady_clock::now();
+            std::vector<std::thread> producers;
+            for (int p = 0; p < producerCount; ++p)
+            {
+                producers.emplace_back([&sharded, &executed]
+                {
+                    for (int i = 0; i < perProducer; ++i)
+                    {
+                        sharded.AddTask([&executed]{ executed++; });
+                    }
+                });
+            }
+            for (auto& t : producers) t.join();
+            while (executed.load() < producerCount * perProducer) std::this_thread::yield();
+            auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - submitStart).count();
+            size_t highWatermark = sharded.GetStats().queueHighWatermark;
+            std::cout << backendCase.name << " 后端 " << producerCount << " 个生产者共 "
+                      << producerCount * perProducer << " 个任务耗时: " << elapsedMs
+                      << " ms，单条通道最大长度: " << highWatermark << "\n";
+            // 三种后端的背压点必须一致：通道长度（Sharded 后端为同一通道在所有分片上的合计）不能超过构造时的容量
+            if (highWatermark > static_cast<size_t>(MaxTaskSize))
+            {
+                std::cout << "错误: " << backendCase.name << " 后端通道长度超过容量 " << MaxTaskSize << "\n";
+                return 1;
+            }
+        }
+    }
+
+    // 测试11: 嵌套并行，每个任务拆出子任务并等待；外层任务数超过队列容量，等待方帮忙执行子任务，不会死锁
+    {
+        FixedThreadPool nested(4);
+        const int outerCount = 400;
+        const int innerCount = 8;
+        std::atomic<int> primes{0};
+        auto nestedStart = std::chrono::steady_clock::now();
+        TaskGroup<FixedThreadPool> outer(nested);
+        for (int i = 0; i < outerCount; ++i)
+        {
+            outer.Run([&nested, &primes, i]
+            {
+                TaskGroup<FixedThreadPool> inner(nested);
+                for (int j = 0; j < innerCount; ++j)
+                {
+                    int start = (i * innerCount + j) * 100;
+                    inner.Run([&primes, start]{ primes += countPrimes(start, start + 99); });
+                }
+                inner.Wait();
+            });
+        }
+        outer.Wait();
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - nestedStart).count();
+        std::cout << "嵌套 TaskGroup " << outerCount << " x " << innerCount << " 个任务完成，素数总数: "
+                  << primes.load() << "，耗时: " << elapsedMs << " ms\n";
+        int expected = countPrimes(0, outerCount * innerCount * 100 - 1);
+        if (primes.load() != expected)
+        {
+            std::cout << "错误: 嵌套 TaskGroup 的素数总数应为 " << expected << "\n";
+            return 1;
+        }
+    }
+
+    // 测试12: 同一批提交的任务互相等待，只有两个工作线程时也不会死锁
+    {
+        FixedThreadPool burstPool(2);
+        if (!BurstMutualWait(burstPool, "FixedThreadPool")) return 1;
+    }
+
     std::cout << "=== FixedThreadPool 压力测试结束 ===" << std::endl;
     return 0;
 }
@@ -1,36 +1,18 @@
 #include "../ThreadPool/include/WorkStealingThreadPool.h"
+#include "../ThreadPool/include/ParallelAlgorithms.h"
+#include "../ThreadPool/include/TaskGraph.h"
+#include "stress_common.h"
 
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <future>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <vector>
 
-int countPrimes(int start, int end)
-{
-    int count = 0;
-    for (int i = start; i <= end; ++i)
-    {
-        if (i < 2) continue;
-        bool isPrime = true;
-        for (int j = 2; j * j <= i; ++j)
-        {
-            if (i % j == 0)
-            {
-                isPrime = false;
-                break;
-            }
-        }
-        if (isPrime) ++count;
-    }
-    return count;
-}
-
-void simulateIO(int milliseconds)
-{
-    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
-}
-
 int main()
 {
     std::cout << "=== WorkStealingThreadPool 压力测试 ===" << std::endl;
@@ -95,13 +77,259 @@ int main()
                 });
             }
         }
-        std::this_thread::sleep_for(std::chrono::seconds(2));
+        // 等待全部任务执行完毕，而不是固定睡眠
+        pool.WaitIdle();
         auto now = std::chrono::high_resolution_clock::now();
         std::cout << "混合任务 " << taskCount << " 个提交完成，总耗时: "
                   << std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime).count()
                   << " ms\n";
     }
 
+    // 测试4: 递归分治，子任务由工作线程提交到自己的本地队列
+    {
+        const int rangeEnd = 800 * 180;
+        const int grain = 180;
+        std::atomic<int> total{0};
+        std::atomic<int> pendingLeaves{(rangeEnd + grain - 1) / grain};
+        std::function<void(int, int)> split = [&](int start, int end)
+        {
+            while (end - start > grain)
+            {
+                int mid = start + ((end - start) / grain / 2) * grain;
+                pool.AddTask([&split, mid, end]{ split(mid, end); });
+                end = mid;
+            }
+            total += countPrimes(start, end - 1);
+            pendingLeaves--;
+        };
+        auto forkStart = std::chrono::high_resolution_clock::now();
+        pool.AddTask([&split, rangeEnd]{ split(0, rangeEnd); });
+        while (pendingLeaves.load() > 0) std::this_thread::yield();
+        auto now = std::chrono::high_resolution_clock::now();
+        std::cout << "递归分治任务完成，素数总数: " << total.load() << "，耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - forkStart).count()
+                  << " ms\n";
+    }
+
+    // 测试5: 批量提交，一次入队并按任务数唤醒线程
+    if (!BulkSubmit(pool, 800, 180)) return 1;
+
+    // 测试6: 唤醒延迟与空闲 CPU 开销
+    if (!WakeLatencyAndIdleCpu(pool)) return 1;
+
+    // 测试7: 并行算法，无需手动切分区间，调用线程参与计算
+    {
+        const size_t rangeEnd = 800 * 180;
+        auto algoStart = std::chrono::high_resolution_clock::now();
+        int primes = ParallelReduce(pool, 0, rangeEnd, 0,
+                                    [](size_t i){ return countPrimes(static_cast<int>(i), static_cast<int>(i)); },
+                                    [](int a, int b){ return a + b; });
+        auto now = std::chrono::high_resolution_clock::now();
+        std::cout << "ParallelReduce 逐元素判断 " << rangeEnd << " 个数，素数总数: " << primes << "，耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - algoStart).count()
+                  << " ms\n";
+        if (primes != countPrimes(0, static_cast<int>(rangeEnd) - 1))
+        {
+            std::cout << "错误: ParallelReduce 的素数总数与串行计算不一致\n";
+            return 1;
+        }
+
+        std::vector<int> squares(1000000);
+        algoStart = std::chrono::high_resolution_clock::now();
+        ParallelFor(pool, 0, squares.size(), [&squares](size_t i){ squares[i] = static_cast<int>(i % 1000) * 2; });
+        std::vector<long long> doubled(squares.size());
+        ParallelTransform(pool, squares.begin(), squares.end(), doubled.begin(),
+                          [](int x){ return static_cast<long long>(x) * x; });
+        long long checksum = ParallelReduce(pool, 0, doubled.size(), 0LL,
+                                            [&doubled](size_t i){ return doubled[i]; },
+                                            [](long long a, long long b){ return a + b; });
+        now = std::chrono::high_resolution_clock::now();
+        std::cout << "ParallelFor/Transform/Reduce 处理 " << squares.size() << " 个元素，校验和: " << checksum
+                  << "，耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - algoStart).count()
+                  << " ms\n";
+        long long expected = 0;
+        for (size_t i = 0; i < squares.size(); ++i)
+        {
+            long long doubledValue = static_cast<long long>(i % 1000) * 2;
+            expected += doubledValue * doubledValue;
+        }
+        if (checksum != expected)
+        {
+            std::cout << "错误: ParallelFor/Transform/Reduce 的校验和应为 " << expected << "\n";
+            return 1;
+        }
+    }
+
+    // 测试8: 运行统计快照，不停止工作线程
+    if (!StatsSnapshot(pool)) return 1;
+
+    // 测试9: 按 CPU 拓扑绑定工作线程，窃取优先选择共享缓存的线程
+    {
+        WorkStealingThreadPool pinnedPool(static_cast<int>(std::thread::hardware_concurrency()),
+                                          WorkerPlacement::Compact);
+        auto pinnedStart = std::chrono::high_resolution_clock::now();
+        int primes = ParallelReduce(pinnedPool, 0, 800 * 180, 0,
+                                    [](size_t i){ return countPrimes(static_cast<int>(i), static_cast<int>(i)); },
+                                    [](int a, int b){ return a + b; });
+        auto now = std::chrono::high_resolution_clock::now();
+        ThreadPoolStats stats = pinnedPool.GetStats();
+        std::cout << "Compact 绑定 ParallelReduce 素数总数: " << primes << "，窃取: " << stats.total.stolen
+                  << "，耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - pinnedStart).count()
+                  << " ms\n";
+    }
+
+    // 测试10: 负载不均衡，所有任务由一个工作线程派生，比较单个窃取与批量窃取
+    for (bool stealHalf : {false, true})
+    {
+        WorkStealingThreadPool imbalancedPool(4, WorkerPlacement::None, stealHalf);
+        const int leafCount = 4000;
+        std::atomic<int> total{0};
+        std::atomic<int> remaining{leafCount};
+        auto imbalanceStart = std::chrono::high_resolution_clock::now();
+        imbalancedPool.AddTask([&]
+        {
+            for (int i = 0; i < leafCount; ++i)
+            {
+                imbalancedPool.AddTask([&total, &remaining, i]
+                {
+                    total += countPrimes(i * 20, (i + 1) * 20 - 1);
+                    remaining--;
+                });
+            }
+        });
+        while (remaining.load() > 0) std::this_thread::yield();
+        auto now = std::chrono::high_resolution_clock::now();
+        ThreadPoolStats stats = imbalancedPool.GetStats();
+        std::cout << (stealHalf ? "批量窃取" : "单个窃取") << " 素数总数: " << total.load()
+                  << "，窃取任务: " << stats.total.stolen
+                  << "，成功窃取次数: " << stats.total.stealAttempts - stats.total.stealFailures
+                  << "，耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - imbalanceStart).count()
+                  << " ms\n";
+    }
+
+    // 测试11: 可挂接后续任务的 Future，请求扇出后逐级处理，整条链上没有线程阻塞等待
+    {
+        const int requestCount = 20000;
+        auto futureStart = std::chrono::high_resolution_clock::now();
+        std::vector<std::future<int>> blocking;
+        blocking.reserve(requestCount);
+        for (int i = 0; i < requestCount; ++i)
+        {
+            blocking.emplace_back(pool.AddTaskWithReturn(countPrimes, i * 10, i * 10 + 9));
+        }
+        long long blockingTotal = 0;
+        for (auto& f : blocking) blockingTotal += f.get() * 2 + 1;
+        auto futureMid = std::chrono::high_resolution_clock::now();
+
+        std::atomic<long long> chainedTotal{0};
+        std::atomic<int> remaining{requestCount};
+        for (int i = 0; i < requestCount; ++i)
+        {
+            pool.AddTaskWithFuture(countPrimes, i * 10, i * 10 + 9)
+                .Then([](int primes){ return primes * 2; })
+                .Then([](int doubled){ return static_cast<long long>(doubled) + 1; })
+                .OnComplete([&chainedTotal, &remaining](Future<long long> result)
+                {
+                    chainedTotal += result.Get();
+                    remaining--;
+                });
+        }
+        while (remaining.load() > 0) std::this_thread::yield();
+        auto futureEnd = std::chrono::high_resolution_clock::now();
+
+        auto failed = pool.AddTaskWithFuture([]() -> int { throw std::runtime_error("请求失败"); })
+                          .Then([](int value){ return value + 1; });
+        std::string error;
+        try
+        {
+            failed.Get();
+        }
+        catch (const std::exception& e)
+        {
+            error = e.what();
+        }
+
+        std::cout << "std::future 逐个 get 结果: " << blockingTotal << "，耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(futureMid - futureStart).count()
+                  << " ms；Future.Then 链结果: " << chainedTotal.load() << "，耗时: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(futureEnd - futureMid).count()
+                  << " ms；异常传播: " << error << "\n";
+        if (chainedTotal.load() != blockingTotal || error.empty())
+        {
+            std::cout << "错误: Then 链的结果应与逐个 get 一致，失败的链应把异常传播给 Get\n";
+            return 1;
+        }
+    }
+
+    // 测试12: 可复用的任务图，每个请求经过多级小阶段，阶段之间按依赖由完成前驱的工作线程直接推进
+    {
+        const int layers = 8;
+        const int width = 6;
+        const int runs = 2000;
+        std::vector<long long> stageResult(layers * width, 0);
+        TaskGraph graph;
+        std::vector<TaskGraph::NodeId> nodes;
+        for (int layer = 0; layer < layers; ++layer)
+        {
+            for (int col = 0; col < width; ++col)
+            {
+                int index = layer * width + col;
+                nodes.push_back(graph.AddNode([&stageResult, index]
+                {
+                    stageResult[index] = countPrimes(index * 50, index * 50 + 49);
+                }));
+            }
+        }
+        // 每个阶段依赖上一层相邻的两个阶段
+        for (int layer = 1; layer < layers; ++layer)
+        {
+            for (int col = 0; col < width; ++col)
+            {
+                graph.AddEdge(nodes[(layer - 1) * width + col], nodes[layer * width + col]);
+                graph.AddEdge(nodes[(layer - 1) * width + (col + 1) % width], nodes[layer * width + col]);
+            }
+        }
+
+        auto graphStart = std::chrono::high_resolution_clock::now();
+        for (int run = 0; run < runs; ++run)
+        {
+            graph.Run(pool);
+        }
+        auto graphEnd = std::chrono::high_resolution_clock::now();
+        long long graphTotal = 0;
+        for (long long value : stageResult) graphTotal += value;
+
+        TaskGraph failing;
+        std::atomic<int> skipped{0};
+        auto first = failing.AddNode([]{ throw std::runtime_error("阶段失败"); });
+        auto second = failing.AddNode([&skipped]{ skipped++; });
+        failing.AddEdge(first, second);
+        std::string error;
+        try
+        {
+            failing.Run(pool);
+        }
+        catch (const std::exception& e)
+        {
+            error = e.what();
+        }
+
+        auto totalUs = std::chrono::duration_cast<std::chrono::microseconds>(graphEnd - graphStart).count();
+        std::cout << "任务图 " << graph.NodeCount() << " 个节点运行 " << runs << " 次，结果: " << graphTotal
+                  << "，平均每次: " << totalUs / runs << " us；异常传播: " << error
+                  << "，后续节点执行次数: " << skipped.load() << "\n";
+        long long expected = 0;
+        for (int index = 0; index < layers * width; ++index) expected += countPrimes(index * 50, index * 50 + 49);
+        if (graphTotal != expected || error.empty() || skipped.load() != 0)
+        {
+            std::cout << "错误: 任务图结果应为 " << expected << "，失败节点的异常应传播给 Run 且后续节点不执行\n";
+            return 1;
+        }
+    }
+
     std::cout << "=== WorkStealingThreadPool 压力测试结束 ===" << std::endl;
     return 0;
 }